@@ -0,0 +1,354 @@
+// ======================================================================
+// \title  BatchFramer.cpp
+// \author ting
+// \brief  cpp file for BatchFramer component implementation class
+// ======================================================================
+
+#include "Components/BatchFramer/BatchFramer.hpp"
+#include "Fw/Types/Assert.hpp"
+#include "Fw/Types/BasicTypes.hpp"
+#include "Fw/Time/TimeInterval.hpp"
+#include <chrono>
+
+namespace Com {
+
+  namespace {
+    //! Framer whose framedOut call is in progress on this thread. The downstream status of our own send arrives
+    //! synchronously on the sending thread, so this tells it apart from a status raised by another thread.
+    thread_local const BatchFramer* t_sendingFramer = nullptr;
+  }
+
+  // ----------------------------------------------------------------------
+  // Component construction and destruction
+  // ----------------------------------------------------------------------
+
+  BatchFramer :: BatchFramer(const char* const compName) : BatchFramerComponentBase(compName),
+      m_protocol(nullptr),
+      m_maxBytes(0),
+      m_maxLatencyNs(0),
+      m_stop(false),
+      m_fill(0),
+      m_packets(0),
+      m_oldestNs(0),
+      m_arrivalSumNs(0),
+      m_linkUp(false),
+      m_upstreamWaiting(true), // ComQueue starts out waiting for the first status
+      m_unsolicitedCount(0),
+      m_sendStatus(Fw::Success::SUCCESS),
+      m_windowStartNs(0),
+      m_windowSends(0),
+      m_windowBytes(0),
+      m_windowPackets(0),
+      m_windowWaitNs(0),
+      m_windowWaitMaxNs(0),
+      m_packetsDropped(0)
+  {
+
+  }
+
+  BatchFramer ::
+    ~BatchFramer(void)
+  {
+
+  }
+
+  void BatchFramer ::
+    setup(Svc::FramingProtocol& protocol)
+  {
+    FW_ASSERT(this->m_protocol == nullptr);
+    this->m_protocol = &protocol;
+    protocol.setup(*this);
+  }
+
+  void BatchFramer ::
+    configure(U32 maxBytes, U32 maxLatencyMs)
+  {
+    this->m_maxBytes = maxBytes;
+    this->m_maxLatencyNs = static_cast<U64>(maxLatencyMs) * 1000000;
+    this->m_statsLock.lock();
+    this->m_windowStartNs = nowNs();
+    this->m_statsLock.unLock();
+  }
+
+  void BatchFramer ::
+    start(const Fw::StringBase& name, NATIVE_UINT_TYPE priority, NATIVE_UINT_TYPE stackSize)
+  {
+    FW_ASSERT(this->m_maxLatencyNs > 0);
+    this->m_stop = false;
+    Os::Task::Arguments arguments(name, BatchFramer::latencyTask, this, priority, stackSize);
+    Os::Task::Status status = this->m_task.start(arguments);
+    FW_ASSERT(status == Os::Task::OP_OK, static_cast<NATIVE_INT_TYPE>(status));
+  }
+
+  void BatchFramer ::
+    stop()
+  {
+    this->m_stop = true;
+  }
+
+  Os::Task::Status BatchFramer ::
+    join()
+  {
+    return this->m_task.join();
+  }
+
+  // ----------------------------------------------------------------------
+  // Handler implementations for user-defined typed input ports
+  // ----------------------------------------------------------------------
+
+  void BatchFramer ::
+    comIn_handler(const NATIVE_INT_TYPE portNum, Fw::ComBuffer& data, U32 context)
+  {
+    // Events jump the batch so they keep the priority ComQueue gave them
+    FwPacketDescriptorType descriptor = 0;
+    bool urgent = (data.deserialize(descriptor) == Fw::FW_SERIALIZE_OK) &&
+                  (descriptor == static_cast<FwPacketDescriptorType>(Fw::ComPacket::FW_PACKET_LOG));
+    data.resetDeser();
+    this->handleFraming(data.getBuffAddr(), data.getBuffLength(), Fw::ComPacket::FW_PACKET_UNKNOWN, urgent);
+  }
+
+  void BatchFramer ::
+    bufferIn_handler(const NATIVE_INT_TYPE portNum, Fw::Buffer& fwBuffer)
+  {
+    this->handleFraming(fwBuffer.getData(), fwBuffer.getSize(), Fw::ComPacket::FW_PACKET_FILE, false);
+    // The packet has been copied into the batch, so the file buffer can go back
+    this->bufferDeallocate_out(0, fwBuffer);
+  }
+
+  void BatchFramer ::
+    comStatusIn_handler(const NATIVE_INT_TYPE portNum, Fw::Success& condition)
+  {
+    // Status of our own send, delivered synchronously from within framedOut on the sending thread. Only that
+    // thread touches m_sendStatus.
+    if (t_sendingFramer == this) {
+      this->m_sendStatus = condition.e;
+      return;
+    }
+    // Unsolicited status, e.g. the driver (re)connecting, possibly while a send is in progress on another thread
+    this->m_statusLock.lock();
+    this->m_linkUp = (condition.e == Fw::Success::SUCCESS);
+    this->m_unsolicitedCount++;
+    this->m_statusLock.unLock();
+    this->reportStatus(condition.e);
+  }
+
+  void BatchFramer ::
+    schedIn_handler(const NATIVE_INT_TYPE portNum, NATIVE_UINT_TYPE context)
+  {
+    // Only the statistics lock is taken here, never the port lock held across sends, so the rate group is not
+    // stalled by a slow link
+    U64 now = nowNs();
+    this->m_statsLock.lock();
+    U64 elapsed = now - this->m_windowStartNs;
+    U32 sends = this->m_windowSends;
+    U64 bytes = this->m_windowBytes;
+    U32 packets = this->m_windowPackets;
+    U64 waitNs = this->m_windowWaitNs;
+    U64 waitMaxNs = this->m_windowWaitMaxNs;
+    U32 packetsDropped = this->m_packetsDropped;
+    this->m_windowStartNs = now;
+    this->m_windowSends = 0;
+    this->m_windowBytes = 0;
+    this->m_windowPackets = 0;
+    this->m_windowWaitNs = 0;
+    this->m_windowWaitMaxNs = 0;
+    this->m_statsLock.unLock();
+
+    F32 sendRate = (elapsed > 0) ? static_cast<F32>(sends * 1.0e9 / elapsed) : 0.0f;
+    U32 bytesPerSend = 0;
+    F32 packetsPerSend = 0.0f;
+    U32 waitAvgUs = 0;
+    if (sends > 0) {
+      bytesPerSend = static_cast<U32>(bytes / sends);
+      packetsPerSend = static_cast<F32>(packets) / static_cast<F32>(sends);
+    }
+    if (packets > 0) {
+      waitAvgUs = static_cast<U32>(waitNs / packets / 1000);
+    }
+    this->tlmWrite_Batch_SendRate(sendRate);
+    this->tlmWrite_Batch_BytesPerSend(bytesPerSend);
+    this->tlmWrite_Batch_PacketsPerSend(packetsPerSend);
+    this->tlmWrite_Batch_WaitAvgUs(waitAvgUs);
+    this->tlmWrite_Batch_WaitMaxUs(static_cast<U32>(waitMaxNs / 1000));
+    this->tlmWrite_Batch_PacketsDropped(packetsDropped);
+  }
+
+  // ----------------------------------------------------------------------
+  // Implementation of Svc::FramingProtocolInterface
+  // ----------------------------------------------------------------------
+
+  Fw::Buffer BatchFramer ::
+    allocate(const U32 size)
+  {
+    if (this->m_batch.getData() != nullptr && (this->m_fill + size) > this->m_batch.getSize()) {
+      if (!this->flush()) {
+        this->drop();
+      }
+    }
+    if (this->m_batch.getData() == nullptr) {
+      this->m_batch = this->framedAllocate_out(0, FW_MAX(this->m_maxBytes, size));
+      this->m_fill = 0;
+      FW_ASSERT(this->m_batch.getSize() >= size, this->m_batch.getSize(), size);
+    }
+    return Fw::Buffer(this->m_batch.getData() + this->m_fill, size);
+  }
+
+  void BatchFramer ::
+    send(Fw::Buffer& outgoing)
+  {
+    FW_ASSERT(outgoing.getData() == this->m_batch.getData() + this->m_fill);
+    FW_ASSERT((this->m_fill + outgoing.getSize()) <= this->m_batch.getSize(), this->m_fill, outgoing.getSize());
+    U64 now = nowNs();
+    if (this->m_packets == 0) {
+      this->m_oldestNs = now;
+    }
+    this->m_fill += outgoing.getSize();
+    this->m_packets++;
+    this->m_arrivalSumNs += now;
+  }
+
+  // ----------------------------------------------------------------------
+  // Helper functions
+  // ----------------------------------------------------------------------
+
+  void BatchFramer ::
+    handleFraming(const U8* const data, const U32 size, Fw::ComPacket::ComPacketType packetType, bool urgent)
+  {
+    FW_ASSERT(this->m_protocol != nullptr);
+    // Every packet from upstream is owed exactly one status
+    this->m_statusLock.lock();
+    this->m_upstreamWaiting = true;
+    this->m_statusLock.unLock();
+
+    this->flushExpired(nowNs());
+    this->m_protocol->frame(data, size, packetType);
+    if (urgent || this->m_maxBytes == 0) {
+      (void)this->flush();
+    }
+
+    // A buffered packet is acknowledged according to the last known link state, so that ComQueue stops
+    // feeding a dead link and resumes on the driver's reconnect status
+    this->m_statusLock.lock();
+    Fw::Success::T status = this->m_linkUp ? Fw::Success::SUCCESS : Fw::Success::FAILURE;
+    this->m_statusLock.unLock();
+    this->reportStatus(status);
+  }
+
+  bool BatchFramer ::
+    flush()
+  {
+    if (this->m_packets == 0) {
+      return true;
+    }
+    this->m_statusLock.lock();
+    bool linkUp = this->m_linkUp;
+    U32 unsolicitedCount = this->m_unsolicitedCount;
+    this->m_statusLock.unLock();
+    if (!linkUp) {
+      // ComStub must not be handed data before it reports a (re)connection
+      return false;
+    }
+
+    U64 now = nowNs();
+    Fw::Buffer outgoing = this->m_batch;
+    outgoing.setSize(this->m_fill);
+    this->m_sendStatus = Fw::Success::SUCCESS;
+    t_sendingFramer = this;
+    (void)this->framedOut_out(0, outgoing);
+    t_sendingFramer = nullptr;
+
+    // A status raised by another thread during the send, e.g. a reconnect, is newer than the send's own
+    this->m_statusLock.lock();
+    if (this->m_unsolicitedCount == unsolicitedCount) {
+      this->m_linkUp = (this->m_sendStatus == Fw::Success::SUCCESS);
+    }
+    this->m_statusLock.unLock();
+
+    if (this->m_sendStatus == Fw::Success::SUCCESS) {
+      this->m_statsLock.lock();
+      this->m_windowSends++;
+      this->m_windowBytes += this->m_fill;
+      this->m_windowPackets += this->m_packets;
+      this->m_windowWaitNs += (now * this->m_packets) - this->m_arrivalSumNs;
+      this->m_windowWaitMaxNs = FW_MAX(this->m_windowWaitMaxNs, now - this->m_oldestNs);
+      this->m_statsLock.unLock();
+    } else {
+      // The driver released the buffer without sending it, so the whole batch is lost
+      this->log_WARNING_HI_Batch_Dropped(this->m_packets);
+      this->m_statsLock.lock();
+      this->m_packetsDropped += this->m_packets;
+      this->m_statsLock.unLock();
+    }
+
+    // Ownership of the batch buffer passed downstream
+    this->m_batch = Fw::Buffer();
+    this->m_fill = 0;
+    this->m_packets = 0;
+    this->m_arrivalSumNs = 0;
+    return true;
+  }
+
+  void BatchFramer ::
+    drop()
+  {
+    if (this->m_batch.getData() == nullptr) {
+      return;
+    }
+    this->log_WARNING_HI_Batch_Dropped(this->m_packets);
+    this->m_statsLock.lock();
+    this->m_packetsDropped += this->m_packets;
+    this->m_statsLock.unLock();
+    this->framedDeallocate_out(0, this->m_batch);
+    this->m_batch = Fw::Buffer();
+    this->m_fill = 0;
+    this->m_packets = 0;
+    this->m_arrivalSumNs = 0;
+  }
+
+  void BatchFramer ::
+    reportStatus(Fw::Success::T status)
+  {
+    this->m_statusLock.lock();
+    if (this->m_upstreamWaiting && this->isConnected_comStatusOut_OutputPort(0)) {
+      Fw::Success condition = status;
+      this->comStatusOut_out(0, condition);
+      // After a failure ComQueue keeps waiting for the reconnect status
+      this->m_upstreamWaiting = (status != Fw::Success::SUCCESS);
+    }
+    this->m_statusLock.unLock();
+  }
+
+  void BatchFramer ::
+    flushExpired(U64 now)
+  {
+    if (this->m_packets > 0 && (now - this->m_oldestNs) >= this->m_maxLatencyNs) {
+      // Nobody upstream waits on this send, so its status only updates the link state
+      (void)this->flush();
+    }
+  }
+
+  void BatchFramer ::
+    latencyTask(void* pointer)
+  {
+    FW_ASSERT(pointer != nullptr);
+    BatchFramer& self = *reinterpret_cast<BatchFramer*>(pointer);
+    U64 periodUs = FW_MAX(self.m_maxLatencyNs / 2000, 1000);
+    Fw::TimeInterval period(static_cast<U32>(periodUs / 1000000), static_cast<U32>(periodUs % 1000000));
+    while (!self.m_stop) {
+      Os::Task::delay(period);
+      // Same lock as the guarded ports, so the batch is never touched by two threads. A batch that would
+      // exceed the budget before the next wake-up is sent now, so no packet waits longer than the budget.
+      self.lock();
+      self.flushExpired(nowNs() + periodUs * 1000);
+      self.unLock();
+    }
+  }
+
+  U64 BatchFramer ::
+    nowNs()
+  {
+    return static_cast<U64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+}
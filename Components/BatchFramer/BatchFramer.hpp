@@ -0,0 +1,182 @@
+// ======================================================================
+// \title  BatchFramer.hpp
+// \author ting
+// \brief  hpp file for BatchFramer component implementation class
+// ======================================================================
+
+#ifndef Com_BatchFramer_HPP
+#define Com_BatchFramer_HPP
+
+#include "Components/BatchFramer/BatchFramerComponentAc.hpp"
+#include "Os/Mutex.hpp"
+#include "Os/Task.hpp"
+#include "Svc/FramingProtocol/FramingProtocol.hpp"
+#include "Svc/FramingProtocol/FramingProtocolInterface.hpp"
+
+#include <atomic>
+
+namespace Com {
+
+  /**
+   * BatchFramer:
+   *   Drop-in replacement for Svc::Framer. Each packet is framed by the
+   * configured protocol as usual, but the frames are packed back to back
+   * into one buffer and handed to the com driver in a single send. A batch
+   * is sent when the next frame does not fit, when an event packet arrives,
+   * or when its oldest packet has waited longer than the latency budget. The
+   * budget is enforced by a task started with start(), which wakes at twice
+   * the budget's rate.
+   *
+   *   ComQueue expects exactly one status per packet it sends. Packets that
+   * are only buffered are acknowledged here; statuses produced by sends of
+   * the latency timer are consumed here.
+   */
+  class BatchFramer :
+    public BatchFramerComponentBase,
+    public Svc::FramingProtocolInterface
+  {
+
+    public:
+
+      // ----------------------------------------------------------------------
+      // Component construction and destruction
+      // ----------------------------------------------------------------------
+
+      //! Construct BatchFramer object
+      BatchFramer(
+          const char* const compName //!< The component name
+      );
+
+      //! Destroy BatchFramer object
+      ~BatchFramer();
+
+      //! Set the framing protocol used for every packet
+      void setup(
+          Svc::FramingProtocol& protocol //!< Protocol, e.g. Svc::FprimeFraming
+      );
+
+      //! Set the batch budgets. A maxBytes of 0 sends every frame on its own, like Svc::Framer.
+      void configure(
+          U32 maxBytes, //!< Size of the batch buffer requested from framedAllocate
+          U32 maxLatencyMs //!< Longest time a packet may wait in a batch
+      );
+
+      //! Start the task sending batches whose latency budget ran out
+      void start(
+          const Fw::StringBase& name, //!< The task name
+          NATIVE_UINT_TYPE priority, //!< The task priority
+          NATIVE_UINT_TYPE stackSize //!< The task stack size
+      );
+
+      //! Ask the latency task to exit
+      void stop();
+
+      //! Wait for the latency task to exit
+      Os::Task::Status join();
+
+    PRIVATE:
+      // ----------------------------------------------------------------------
+      // Handler implementations for typed input ports
+      // ----------------------------------------------------------------------
+
+      //! Handler implementation for comIn
+      void comIn_handler(
+          const NATIVE_INT_TYPE portNum, /*!< The port number*/
+          Fw::ComBuffer& data, /*!< Buffer containing packet data*/
+          U32 context /*!< Call context value; meaning chosen by user*/
+      ) override;
+
+      //! Handler implementation for bufferIn
+      void bufferIn_handler(
+          const NATIVE_INT_TYPE portNum, /*!< The port number*/
+          Fw::Buffer& fwBuffer /*!< The buffer*/
+      ) override;
+
+      //! Handler implementation for comStatusIn
+      void comStatusIn_handler(
+          const NATIVE_INT_TYPE portNum, /*!< The port number*/
+          Fw::Success& condition /*!< Condition success/failure*/
+      ) override;
+
+      //! Handler implementation for schedIn
+      void schedIn_handler(
+          const NATIVE_INT_TYPE portNum, /*!< The port number*/
+          NATIVE_UINT_TYPE context /*!< The call order*/
+      ) override;
+
+    PRIVATE:
+      // ----------------------------------------------------------------------
+      // Implementation of Svc::FramingProtocolInterface
+      // ----------------------------------------------------------------------
+
+      //! Hand the protocol a slice of the current batch, sending the batch first if the frame does not fit
+      Fw::Buffer allocate(const U32 size) override;
+
+      //! Account a frame written into the slice returned by allocate
+      void send(Fw::Buffer& outgoing) override;
+
+      // ----------------------------------------------------------------------
+      // Helper functions
+      // ----------------------------------------------------------------------
+
+      //! Frame one packet and acknowledge it to the upstream component
+      void handleFraming(const U8* const data, const U32 size, Fw::ComPacket::ComPacketType packetType, bool urgent);
+
+      //! Send the current batch if the link is up. Returns true if the batch is now empty.
+      bool flush();
+
+      //! Return the current batch to the buffer manager without sending it
+      void drop();
+
+      //! Relay a status upstream if the upstream component is waiting for one
+      void reportStatus(Fw::Success::T status);
+
+      //! Send the batch if its oldest packet has waited the latency budget. Called with the port lock held.
+      void flushExpired(U64 now);
+
+      //! Body of the latency task
+      static void latencyTask(void* pointer);
+
+      //! Current monotonic time in nanoseconds
+      static U64 nowNs();
+
+      //!< Framing protocol and batch budgets
+      Svc::FramingProtocol* m_protocol;
+      U32 m_maxBytes;
+      U64 m_maxLatencyNs;
+
+      //!< Task enforcing the latency budget
+      Os::Task m_task;
+      std::atomic<bool> m_stop;
+
+      //!< Batch under construction
+      Fw::Buffer m_batch;
+      U32 m_fill;
+      U32 m_packets;
+      U64 m_oldestNs;
+      U64 m_arrivalSumNs;
+
+      //!< Link state as last reported downstream, and whether upstream awaits a status
+      Os::Mutex m_statusLock;
+      bool m_linkUp;
+      bool m_upstreamWaiting;
+      U32 m_unsolicitedCount;
+
+      //!< Status of the send in progress, only accessed on the sending thread
+      Fw::Success::T m_sendStatus;
+
+      //!< Statistics of the current telemetry window, never locked across a send
+      Os::Mutex m_statsLock;
+      U64 m_windowStartNs;
+      U32 m_windowSends;
+      U64 m_windowBytes;
+      U32 m_windowPackets;
+      U64 m_windowWaitNs;
+      U64 m_windowWaitMaxNs;
+      U32 m_packetsDropped;
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,30 @@
+// ----------------------------------------------------------------------
+// TestMain.cpp
+// ----------------------------------------------------------------------
+
+#include "BatchFramerTester.hpp"
+
+TEST(Nominal, Batching) {
+  Com::BatchFramerTester tester;
+  tester.testBatching();
+}
+
+TEST(Nominal, LinkDown) {
+  Com::BatchFramerTester tester;
+  tester.testLinkDown();
+}
+
+TEST(OffNominal, SendFailure) {
+  Com::BatchFramerTester tester;
+  tester.testSendFailure();
+}
+
+TEST(OffNominal, ReconnectDuringSend) {
+  Com::BatchFramerTester tester;
+  tester.testReconnectDuringSend();
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,178 @@
+// ======================================================================
+// \title  BatchFramerTester.cpp
+// \author ting
+// \brief  cpp file for BatchFramer component test harness implementation class
+// ======================================================================
+
+#include "BatchFramerTester.hpp"
+#include <thread>
+
+namespace Com {
+
+  // ----------------------------------------------------------------------
+  // Construction and destruction
+  // ----------------------------------------------------------------------
+
+  BatchFramerTester ::
+    BatchFramerTester() :
+      BatchFramerGTestBase("BatchFramerTester", BatchFramerTester::MAX_HISTORY_SIZE),
+      component("BatchFramer"),
+      m_allocations(0),
+      m_sendStatus(Fw::Success::SUCCESS),
+      m_reconnectDuringSend(false)
+  {
+    this->initComponents();
+    this->connectPorts();
+    this->component.setup(this->framing);
+    // A latency budget far beyond the test, so only events and full batches send
+    this->component.configure(BATCH_SIZE, 100000);
+  }
+
+  BatchFramerTester ::
+    ~BatchFramerTester()
+  {
+
+  }
+
+  // ----------------------------------------------------------------------
+  // Tests
+  // ----------------------------------------------------------------------
+
+  void BatchFramerTester ::
+    testBatching()
+  {
+    this->driverStatus(Fw::Success::SUCCESS);
+    ASSERT_from_comStatusOut_SIZE(1);
+    this->clearHistory();
+
+    for (U32 i = 0; i < 3; i++) {
+      this->sendPacket(Fw::ComPacket::FW_PACKET_TELEM);
+    }
+    ASSERT_from_framedOut_SIZE(0);
+    ASSERT_from_comStatusOut_SIZE(3);
+    for (U32 i = 0; i < 3; i++) {
+      ASSERT_EQ(this->fromPortHistory_comStatusOut->at(i).condition, Fw::Success::SUCCESS);
+    }
+
+    this->sendPacket(Fw::ComPacket::FW_PACKET_LOG);
+    ASSERT_from_framedOut_SIZE(1);
+    ASSERT_EQ(this->fromPortHistory_framedOut->at(0).sendBuffer.getSize(), 4 * FRAME_SIZE);
+    ASSERT_from_comStatusOut_SIZE(4);
+    ASSERT_EQ(this->fromPortHistory_comStatusOut->at(3).condition, Fw::Success::SUCCESS);
+    ASSERT_EQ(this->m_allocations, 1);
+  }
+
+  void BatchFramerTester ::
+    testLinkDown()
+  {
+    this->sendPacket(Fw::ComPacket::FW_PACKET_LOG);
+    ASSERT_from_framedOut_SIZE(0);
+    ASSERT_from_comStatusOut_SIZE(1);
+    ASSERT_EQ(this->fromPortHistory_comStatusOut->at(0).condition, Fw::Success::FAILURE);
+
+    // The reconnect resumes ComQueue; the held frame goes out with the next event
+    this->driverStatus(Fw::Success::SUCCESS);
+    ASSERT_from_comStatusOut_SIZE(2);
+    ASSERT_EQ(this->fromPortHistory_comStatusOut->at(1).condition, Fw::Success::SUCCESS);
+    this->sendPacket(Fw::ComPacket::FW_PACKET_LOG);
+    ASSERT_from_framedOut_SIZE(1);
+    ASSERT_EQ(this->fromPortHistory_framedOut->at(0).sendBuffer.getSize(), 2 * FRAME_SIZE);
+  }
+
+  void BatchFramerTester ::
+    testSendFailure()
+  {
+    this->driverStatus(Fw::Success::SUCCESS);
+    this->clearHistory();
+
+    this->m_sendStatus = Fw::Success::FAILURE;
+    this->sendPacket(Fw::ComPacket::FW_PACKET_TELEM);
+    this->sendPacket(Fw::ComPacket::FW_PACKET_LOG);
+    ASSERT_from_framedOut_SIZE(1);
+    ASSERT_from_comStatusOut_SIZE(2);
+    ASSERT_EQ(this->fromPortHistory_comStatusOut->at(1).condition, Fw::Success::FAILURE);
+    ASSERT_EVENTS_Batch_Dropped_SIZE(1);
+    ASSERT_EVENTS_Batch_Dropped(0, 2);
+
+    // The link is now down, so nothing more is sent
+    this->sendPacket(Fw::ComPacket::FW_PACKET_LOG);
+    ASSERT_from_framedOut_SIZE(1);
+
+    this->invoke_to_schedIn(0, 0);
+    ASSERT_TLM_Batch_PacketsDropped_SIZE(1);
+    ASSERT_TLM_Batch_PacketsDropped(0, 2);
+  }
+
+  void BatchFramerTester ::
+    testReconnectDuringSend()
+  {
+    this->driverStatus(Fw::Success::SUCCESS);
+    this->clearHistory();
+
+    this->m_sendStatus = Fw::Success::FAILURE;
+    this->m_reconnectDuringSend = true;
+    this->sendPacket(Fw::ComPacket::FW_PACKET_LOG);
+    ASSERT_from_framedOut_SIZE(1);
+    // Exactly one status for the packet: the reconnect, not the failure of the send
+    ASSERT_from_comStatusOut_SIZE(1);
+    ASSERT_EQ(this->fromPortHistory_comStatusOut->at(0).condition, Fw::Success::SUCCESS);
+    ASSERT_EVENTS_Batch_Dropped_SIZE(1);
+
+    // The reconnect left the link up
+    this->m_sendStatus = Fw::Success::SUCCESS;
+    this->m_reconnectDuringSend = false;
+    this->sendPacket(Fw::ComPacket::FW_PACKET_LOG);
+    ASSERT_from_framedOut_SIZE(2);
+    ASSERT_from_comStatusOut_SIZE(2);
+    ASSERT_EQ(this->fromPortHistory_comStatusOut->at(1).condition, Fw::Success::SUCCESS);
+  }
+
+  // ----------------------------------------------------------------------
+  // Handlers for typed from ports
+  // ----------------------------------------------------------------------
+
+  Fw::Buffer BatchFramerTester ::
+    from_framedAllocate_handler(NATIVE_INT_TYPE portNum, U32 size)
+  {
+    this->pushFromPortEntry_framedAllocate(size);
+    EXPECT_LE(size, BATCH_SIZE);
+    U8* data = this->m_storage[this->m_allocations % 2];
+    this->m_allocations++;
+    return Fw::Buffer(data, size);
+  }
+
+  Drv::SendStatus BatchFramerTester ::
+    from_framedOut_handler(NATIVE_INT_TYPE portNum, Fw::Buffer& sendBuffer)
+  {
+    this->pushFromPortEntry_framedOut(sendBuffer);
+    if (this->m_reconnectDuringSend) {
+      // The driver thread reconnects while this send is still in progress
+      std::thread driver([this]() { this->driverStatus(Fw::Success::SUCCESS); });
+      driver.join();
+    }
+    // Like ComStub, report the status of the send synchronously from within it
+    this->driverStatus(this->m_sendStatus);
+    return (this->m_sendStatus == Fw::Success::SUCCESS) ? Drv::SendStatus::SEND_OK : Drv::SendStatus::SEND_ERROR;
+  }
+
+  // ----------------------------------------------------------------------
+  // Helper functions
+  // ----------------------------------------------------------------------
+
+  void BatchFramerTester ::
+    sendPacket(Fw::ComPacket::ComPacketType type)
+  {
+    Fw::ComBuffer buffer;
+    ASSERT_EQ(buffer.serialize(static_cast<FwPacketDescriptorType>(type)), Fw::FW_SERIALIZE_OK);
+    ASSERT_EQ(buffer.serialize(static_cast<U32>(0xC0FFEE)), Fw::FW_SERIALIZE_OK);
+    this->invoke_to_comIn(0, buffer, 0);
+  }
+
+  void BatchFramerTester ::
+    driverStatus(Fw::Success::T status)
+  {
+    Fw::Success condition = status;
+    this->invoke_to_comStatusIn(0, condition);
+  }
+
+}
@@ -0,0 +1,130 @@
+// ======================================================================
+// \title  BatchFramerTester.hpp
+// \author ting
+// \brief  hpp file for BatchFramer component test harness implementation class
+// ======================================================================
+
+#ifndef Com_BatchFramerTester_HPP
+#define Com_BatchFramerTester_HPP
+
+#include "Components/BatchFramer/BatchFramerGTestBase.hpp"
+#include "Components/BatchFramer/BatchFramer.hpp"
+#include "Svc/FramingProtocol/FprimeProtocol.hpp"
+
+namespace Com {
+
+  class BatchFramerTester :
+    public BatchFramerGTestBase
+  {
+
+    public:
+
+      // ----------------------------------------------------------------------
+      // Constants
+      // ----------------------------------------------------------------------
+
+      // Maximum size of histories storing events, telemetry, and port outputs
+      static const NATIVE_INT_TYPE MAX_HISTORY_SIZE = 20;
+
+      // Instance ID supplied to the component instance under test
+      static const NATIVE_INT_TYPE TEST_INSTANCE_ID = 0;
+
+      // Size of the batch buffers
+      static const U32 BATCH_SIZE = 1024;
+
+      // Size of one framed test packet: descriptor and a U32 payload, in an F´ frame
+      static const U32 FRAME_SIZE = Svc::FpFrameHeader::SIZE + 2 * sizeof(U32) + HASH_DIGEST_LENGTH;
+
+    public:
+
+      // ----------------------------------------------------------------------
+      // Construction and destruction
+      // ----------------------------------------------------------------------
+
+      //! Construct object BatchFramerTester
+      BatchFramerTester();
+
+      //! Destroy object BatchFramerTester
+      ~BatchFramerTester();
+
+    public:
+
+      // ----------------------------------------------------------------------
+      // Tests
+      // ----------------------------------------------------------------------
+
+      //! Telemetry is batched and acknowledged at once; an event sends the batch
+      void testBatching();
+
+      //! Nothing is sent before the driver reports a connection
+      void testLinkDown();
+
+      //! A failed send counts the batch as dropped and stops further sends
+      void testSendFailure();
+
+      //! A reconnect raised by another thread during a failing send is relayed and wins
+      void testReconnectDuringSend();
+
+    private:
+
+      // ----------------------------------------------------------------------
+      // Handlers for typed from ports
+      // ----------------------------------------------------------------------
+
+      //! Handler implementation for framedAllocate
+      Fw::Buffer from_framedAllocate_handler(
+          NATIVE_INT_TYPE portNum, //!< The port number
+          U32 size //!< The size
+      ) override;
+
+      //! Handler implementation for framedOut, standing in for ComStub
+      Drv::SendStatus from_framedOut_handler(
+          NATIVE_INT_TYPE portNum, //!< The port number
+          Fw::Buffer& sendBuffer //!< Data to send
+      ) override;
+
+    private:
+
+      // ----------------------------------------------------------------------
+      // Helper functions
+      // ----------------------------------------------------------------------
+
+      //! Connect ports
+      void connectPorts();
+
+      //! Initialize components
+      void initComponents();
+
+      //! Send one packet of the given type to comIn
+      void sendPacket(Fw::ComPacket::ComPacketType type);
+
+      //! Report a status on comStatusIn, as the driver does
+      void driverStatus(Fw::Success::T status);
+
+    private:
+
+      // ----------------------------------------------------------------------
+      // Member variables
+      // ----------------------------------------------------------------------
+
+      //! The component under test
+      BatchFramer component;
+
+      //! Framing protocol used by the component
+      Svc::FprimeFraming framing;
+
+      //! Storage handed out by framedAllocate
+      U8 m_storage[2][BATCH_SIZE];
+      U32 m_allocations;
+
+      //! Status the stand-in driver reports for the next sends
+      Fw::Success::T m_sendStatus;
+
+      //! Whether the stand-in driver reconnects from another thread during the next send
+      bool m_reconnectDuringSend;
+
+  };
+
+}
+
+#endif
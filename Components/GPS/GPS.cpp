@@ -7,7 +7,11 @@
 #include "Components/GPS/GPS.hpp"
 #include "Fw/Types/BasicTypes.hpp"
 #include "Fw/Logger/Logger.hpp"
+#include "Components/Profiler/ProfileScope.hpp"
+#include "Components/GpsTime/GpsTime.hpp"
 // #include "Drv/ByteStreamDriverModel/ByteStreamRecvPortAc.hpp"
+#include <cctype>
+#include <cstdlib>
 #include <cstring>
 #include <string.h>
 
@@ -34,85 +38,166 @@ namespace Gnc {
   // ----------------------------------------------------------------------
 
   void GPS ::recv_handler(const NATIVE_INT_TYPE portNum,Fw::Buffer &recvBuffer,const Drv::RecvStatus &recvStatus){
-    int status = 0;
+    PROF_SCOPE("gps.recv");
+    // Sentences completed by this buffer ended no later than now; this is the fix capture time passed to gpsTime
+    U64 recvNs = GpsTime::monotonicNs();
     U32 buffsize = recvBuffer.getSize();
     char* ptr = reinterpret_cast<char*>(recvBuffer.getData());
-    GpsPacket packet;
 
     if (recvStatus != Drv::RecvStatus::RECV_OK) {
         Fw::Logger::log("[WARNING] Received buffer with bad packet: %d\n", recvStatus);
         this->deallocate_out(0, recvBuffer);
         return;
     }
-    // append to recv buffer
-    if (this->m_recvSize < GPS_DATA_LENGTH){
-      // copy data to buffer
-      memcpy(&this->m_uartBuffers[this->m_recvSize], ptr, buffsize);
-      this->m_recvSize += buffsize;
-      this->m_uartBuffers[this->m_recvSize] = '\0';
-    } else {
-      
-      float time, latitude, longitude, altitude;
-      char ns, ew;
-      int quality, satellites;
-      float hdop, geoidheight;
-      ptr = this->m_uartBuffers;
-
-      while ((ptr = strstr(ptr, "$GNGGA")) != NULL) {
-        
-        int parsed = sscanf(ptr, "$GNGGA,%f,%f,%c,%f,%c,%d,%d,%f,%f,M,%f,M",
-                            &time, &latitude, &ns, &longitude, &ew, &quality, &satellites, &hdop, &altitude, &geoidheight);
-        if (parsed == 10) {
-            //printf("Time: %f, Latitude: %f%c, Longitude: %f%c, Quality: %d, Satellites: %d, HDOP: %f, Altitude: %f, GeoidHeight: %f\n",
-            //      time, latitude, ns, longitude, ew, quality, satellites, hdop, altitude, geoidheight);
-            break;
+    // split the stream into NMEA sentences as it arrives
+    for (U32 i = 0; i < buffsize; i++) {
+      char c = ptr[i];
+      if (c == '\n' || c == '\r') {
+        if (this->m_recvSize > 0) {
+          this->m_uartBuffers[this->m_recvSize] = '\0';
+          this->parseSentence(this->m_uartBuffers, recvNs);
+          this->m_recvSize = 0;
         }
-        ptr++;  // Move to the next character to avoid infinite loop
-      
-      }
-      //printf("Time: %f, Latitude: %f%c, Longitude: %f%c, Quality: %d, Satellites: %d, HDOP: %f, Altitude: %f, GeoidHeight: %f\n\n",
-      //            time, latitude, ns, longitude, ew, quality, satellites, hdop, altitude, geoidheight);
-      this->m_recvSize = 0;
-      
-      // set the packet data
-      packet.utcTime = time;
-      packet.latitude = latitude;
-      packet.northSouth = ns;
-      packet.longitude = longitude;
-      packet.eastWest = ew;
-      packet.gpsQuality = quality;
-      packet.numSatellites = satellites;
-      packet.hdop = hdop;
-      packet.altitude = altitude;        
-      packet.geoidalSeparation  = geoidheight;
-      
-      float lat_deg = (int)(packet.latitude / 100.0f);  // Extracting degrees from ddmm.mm format
-      float lat_min = packet.latitude - (lat_deg * 100.0f);  // Extracting minutes from ddmm.mm format
-      float lat = lat_deg + lat_min / 60.0f;  // Converting to decimal format
-      lat = lat * ((packet.northSouth == 'N') ? 1 : -1);  // Applying North/South orientation
-
-      float lon_deg = (int)(packet.longitude / 100.0f);  // Extracting degrees from dddmm.mm format
-      float lon_min = packet.longitude - (lon_deg * 100.0f);  // Extracting minutes from dddmm.mm format
-      float lon = lon_deg + lon_min / 60.0f;  // Converting to decimal format
-      lon = lon * ((packet.eastWest == 'E') ? 1 : -1);  // Applying East/West orientation
-
-      this->tlmWrite_Gps_Latitude(lat);
-      this->tlmWrite_Gps_Longitude(lon);
-      this->tlmWrite_Gps_Altitude(packet.altitude);
-      this->tlmWrite_Gps_Count(packet.numSatellites);
-
-      if (packet.gpsQuality == 0 && m_locked) {
-          m_locked = false;
-          this->log_WARNING_HI_Gps_LockLost();
-      } else if (packet.gpsQuality >= 1 && !m_locked) {
-          m_locked = true;
-          this->log_ACTIVITY_HI_Gps_LockAquired();
+      } else if (this->m_recvSize < GPS_DATA_LENGTH - 1) {
+        this->m_uartBuffers[this->m_recvSize++] = c;
+      } else {
+        // no line end within the buffer: drop the garbage and resynchronize on the next line
+        this->m_recvSize = 0;
       }
-
     }
     this->deallocate_out(0, recvBuffer);
 }
 
+  // ----------------------------------------------------------------------
+  // Helper functions
+  // ----------------------------------------------------------------------
+
+  void GPS ::parseSentence(const char* sentence, U64 recvNs){
+    // The topology's time is derived from these sentences, so anything corrupted on the line is dropped
+    if (!checksumValid(sentence)) {
+      return;
+    }
+    if (strncmp(sentence, "$GNRMC,", 7) == 0) {
+      this->parseRmc(sentence, recvNs);
+    } else if (strncmp(sentence, "$GNGGA,", 7) == 0) {
+      this->parseGga(sentence);
+    }
+  }
+
+  void GPS ::parseRmc(const char* sentence, U64 recvNs){
+    // $GNRMC,hhmmss.ss,A,ddmm.mm,N,dddmm.mm,E,speed,course,ddmmyy,...: time, validity and date of the fix
+    double time;
+    char valid;
+    const char* date = nmeaField(sentence, 9);
+    U32 day, month, year;
+    if (sscanf(sentence, "$GNRMC,%lf,%c,", &time, &valid) != 2 || valid != 'A' || date == NULL ||
+        sscanf(date, "%2u%2u%2u", &day, &month, &year) != 3 || day < 1 || day > 31 || month < 1 || month > 12) {
+      return;
+    }
+    if (this->isConnected_timeFix_OutputPort(0)) {
+      U32 hhmmss = static_cast<U32>(time);
+      F64 timeOfDay = (hhmmss / 10000) * 3600 + ((hhmmss / 100) % 100) * 60 + (hhmmss % 100) + (time - hhmmss);
+      this->timeFix_out(0, daysFromCivil(2000 + year, month, day), timeOfDay, recvNs);
+    }
+  }
+
+  void GPS ::parseGga(const char* sentence){
+    double time;
+    float latitude, longitude, altitude;
+    char ns, ew;
+    int quality, satellites;
+    float hdop, geoidheight;
+    GpsPacket packet;
+
+    int parsed = sscanf(sentence, "$GNGGA,%lf,%f,%c,%f,%c,%d,%d,%f,%f,M,%f,M",
+                        &time, &latitude, &ns, &longitude, &ew, &quality, &satellites, &hdop, &altitude, &geoidheight);
+    if (parsed != 10) {
+      // Without a fix the position fields are empty; the quality is the 6th field
+      const char* field = nmeaField(sentence, 6);
+      if (field != NULL && *field == '0' && m_locked) {
+        m_locked = false;
+        this->log_WARNING_HI_Gps_LockLost();
+      }
+      return;
+    }
+    //printf("Time: %f, Latitude: %f%c, Longitude: %f%c, Quality: %d, Satellites: %d, HDOP: %f, Altitude: %f, GeoidHeight: %f\n\n",
+    //            time, latitude, ns, longitude, ew, quality, satellites, hdop, altitude, geoidheight);
+
+    // set the packet data
+    packet.utcTime = time;
+    packet.latitude = latitude;
+    packet.northSouth = ns;
+    packet.longitude = longitude;
+    packet.eastWest = ew;
+    packet.gpsQuality = quality;
+    packet.numSatellites = satellites;
+    packet.hdop = hdop;
+    packet.altitude = altitude;        
+    packet.geoidalSeparation  = geoidheight;
+    
+    float lat_deg = (int)(packet.latitude / 100.0f);  // Extracting degrees from ddmm.mm format
+    float lat_min = packet.latitude - (lat_deg * 100.0f);  // Extracting minutes from ddmm.mm format
+    float lat = lat_deg + lat_min / 60.0f;  // Converting to decimal format
+    lat = lat * ((packet.northSouth == 'N') ? 1 : -1);  // Applying North/South orientation
+
+    float lon_deg = (int)(packet.longitude / 100.0f);  // Extracting degrees from dddmm.mm format
+    float lon_min = packet.longitude - (lon_deg * 100.0f);  // Extracting minutes from dddmm.mm format
+    float lon = lon_deg + lon_min / 60.0f;  // Converting to decimal format
+    lon = lon * ((packet.eastWest == 'E') ? 1 : -1);  // Applying East/West orientation
+
+    this->tlmWrite_Gps_Latitude(lat);
+    this->tlmWrite_Gps_Longitude(lon);
+    this->tlmWrite_Gps_Altitude(packet.altitude);
+    this->tlmWrite_Gps_Count(packet.numSatellites);
+
+    if (packet.gpsQuality == 0 && m_locked) {
+        m_locked = false;
+        this->log_WARNING_HI_Gps_LockLost();
+    } else if (packet.gpsQuality >= 1 && !m_locked) {
+        m_locked = true;
+        this->log_ACTIVITY_HI_Gps_LockAquired();
+    }
+}
+
+  bool GPS ::checksumValid(const char* sentence){
+    // $<body>*hh, where hh is the hex XOR of every body character
+    if (sentence[0] != '$') {
+      return false;
+    }
+    U8 sum = 0;
+    const char* c = sentence + 1;
+    for (; *c != '\0' && *c != '*'; c++) {
+      sum ^= static_cast<U8>(*c);
+    }
+    if (*c != '*' || strlen(c + 1) != 2 || !isxdigit(static_cast<unsigned char>(c[1])) ||
+        !isxdigit(static_cast<unsigned char>(c[2]))) {
+      return false;
+    }
+    return strtoul(c + 1, NULL, 16) == sum;
+  }
+
+  const char* GPS ::nmeaField(const char* sentence, U32 index){
+    const char* field = sentence;
+    for (U32 i = 0; i < index && field != NULL; i++) {
+      field = strchr(field, ',');
+      if (field != NULL) {
+        field++;
+      }
+    }
+    return field;
+  }
+
+  U32 GPS ::daysFromCivil(U32 year, U32 month, U32 day){
+    // Days since 1970-01-01 in the proleptic Gregorian calendar, years starting in March
+    I32 y = static_cast<I32>(year) - ((month <= 2) ? 1 : 0);
+    I32 era = y / 400;
+    U32 yearOfEra = static_cast<U32>(y - era * 400);
+    U32 monthFromMarch = (month > 2) ? month - 3 : month + 9;
+    U32 dayOfYear = (153 * monthFromMarch + 2) / 5 + day - 1;
+    U32 dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return static_cast<U32>(era * 146097 + static_cast<I32>(dayOfEra) - 719468);
+  }
+
   // ----------------------------------------------------------------------
   // Command handler implementations
   // ----------------------------------------------------------------------
@@ -126,6 +211,7 @@ namespace Gnc {
         const U32 cmdSeq
     )
   {
+    PROF_SCOPE("gps.reportLockStatus");
     //Locked-force print
     if (m_locked) {
         log_ACTIVITY_HI_Gps_LockAquired();
@@ -23,7 +23,7 @@ namespace Gnc {
    * received via the NMEA GPS receiver.
    */
   struct GpsPacket {
-    float utcTime;           // 1) Time (UTC)
+    double utcTime;          // 1) Time (UTC, hhmmss.ss format)
     float latitude;          // 2) Latitude (in ddmm.mm format)
     char northSouth;         // 3) N or S (North or South)
     float longitude;         // 4) Longitude (in dddmm.mm format)
@@ -66,6 +66,38 @@ namespace Gnc {
         const Drv::RecvStatus &recvStatus 
       );
 
+    PRIVATE:
+
+      // ----------------------------------------------------------------------
+      // Helper functions
+      // ----------------------------------------------------------------------
+
+      //! Parse one NMEA sentence, without its line end, if its checksum is valid
+      void parseSentence(
+        const char* sentence, //!< The null-terminated sentence
+        U64 recvNs //!< Monotonic time the end of the sentence was received
+      );
+
+      //! Publish the date and time of a valid $GNRMC fix to the time source
+      void parseRmc(
+        const char* sentence, //!< The null-terminated sentence
+        U64 recvNs //!< Monotonic time the end of the sentence was received
+      );
+
+      //! Publish the position and lock state of a $GNGGA sentence
+      void parseGga(
+        const char* sentence //!< The null-terminated sentence
+      );
+
+      //! Whether the sentence ends with a matching *hh checksum
+      static bool checksumValid(const char* sentence);
+
+      //! Start of the comma-separated field at index, 0 being the sentence type, or NULL
+      static const char* nmeaField(const char* sentence, U32 index);
+
+      //! Days since 1970-01-01 of a UTC calendar date
+      static U32 daysFromCivil(U32 year, U32 month, U32 day);
+
     PRIVATE:
 
       // ----------------------------------------------------------------------
@@ -82,7 +114,7 @@ namespace Gnc {
 
       //!< Has the device acquired GPS lock?
       bool m_locked;
-      //!< Create member variables to store buffers and the data array that those buffers use for storage
+      //!< Sentence being received, up to its line end
       char m_uartBuffers[GPS_DATA_LENGTH];
       U16 m_recvSize = 0;
 
@@ -0,0 +1,252 @@
+// ======================================================================
+// \title  GpsTime.cpp
+// \author ting
+// \brief  cpp file for GpsTime component implementation class
+// ======================================================================
+
+#include "Components/GpsTime/GpsTime.hpp"
+#include "Fw/Types/BasicTypes.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+namespace Gnc {
+
+  namespace {
+    const I64 NS_PER_SECOND = 1000000000LL;
+    const I64 NS_PER_DAY = 86400LL * NS_PER_SECOND;
+
+    //! Offsets larger than this, while locked, start a catch-up: the whole offset is slewed out at each fix, at
+    //! most at MAX_SLEW_PPB, and kept out of the drift estimate until it is back under CATCH_UP_EXIT_NS
+    const I64 CATCH_UP_ENTER_NS = 50000000LL;
+    const I64 CATCH_UP_EXIT_NS = 10000000LL;
+    //! Offsets larger than this on the first fix after holdover are reported as a step
+    const I64 STEP_REPORT_NS = 500000000LL;
+    //! Share of each offset slewed out over the next fix interval (phase) and folded into the drift (frequency)
+    //! Tuned for 1 Hz fixes with the 10 ms resolution of NMEA timestamps
+    const F64 PHASE_GAIN = 0.05;
+    const F64 FREQUENCY_GAIN = 0.0005;
+    //! Largest drift accepted from the estimator, 500 ppm
+    const F64 MAX_DRIFT_PPB = 500000.0;
+    //! Largest slew rate, 5%, so the served time always advances
+    const F64 MAX_SLEW_PPB = 50000000.0;
+    //! Slew duration used until two fixes give the fix interval, and its bounds
+    const U64 DEFAULT_SLEW_NS = 1000000000ULL;
+    const U64 MIN_SLEW_NS = 100000000ULL;
+    const U64 MAX_SLEW_NS = 10000000000ULL;
+
+    I64 systemNs() {
+      return static_cast<I64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    //! Latest time served to this thread since the last step, so no request writes shared memory
+    struct ServedFloor {
+      const void* owner;
+      U32 steps;
+      I64 lastNs;
+    };
+    thread_local ServedFloor t_servedFloor = {nullptr, 0, 0};
+  }
+
+  // ----------------------------------------------------------------------
+  // Component construction and destruction
+  // ----------------------------------------------------------------------
+
+  GpsTime :: GpsTime(const char* const compName) : GpsTimeComponentBase(compName),
+      m_seq(0),
+      m_baseUtcNs(systemNs()),
+      m_baseMonoNs(monotonicNs()),
+      m_driftPpb(0.0),
+      m_slewPpb(0.0),
+      m_slewNs(0),
+      m_status(GpsTimeStatus::FREE_RUN),
+      m_steps(0),
+      m_lastFixNs(0),
+      m_lastOffsetNs(0.0),
+      m_catchingUp(false),
+      m_holdoverAfterNs(5 * NS_PER_SECOND),
+      m_fixLatencyNs(0)
+  {
+
+  }
+
+  GpsTime ::
+    ~GpsTime(void)
+  {
+
+  }
+
+  void GpsTime ::
+    configure(U32 holdoverAfterMs, U32 fixLatencyUs)
+  {
+    this->m_lock.lock();
+    this->m_holdoverAfterNs = static_cast<U64>(holdoverAfterMs) * 1000000;
+    this->m_fixLatencyNs = static_cast<U64>(fixLatencyUs) * 1000;
+    this->m_lock.unLock();
+  }
+
+  U64 GpsTime ::
+    monotonicNs()
+  {
+    return static_cast<U64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  // ----------------------------------------------------------------------
+  // Handler implementations for user-defined typed input ports
+  // ----------------------------------------------------------------------
+
+  void GpsTime ::
+    timeGetPort_handler(const NATIVE_INT_TYPE portNum, Fw::Time& time)
+  {
+    I64 utcNs = this->servedAt(monotonicNs());
+    // Context 0 as served by Svc::ChronoTime; times in different contexts do not compare. The clock state is
+    // published in Time_Status instead.
+    time.set(TB_WORKSTATION_TIME, 0,
+             static_cast<U32>(utcNs / NS_PER_SECOND), static_cast<U32>((utcNs % NS_PER_SECOND) / 1000));
+  }
+
+  void GpsTime ::
+    fixIn_handler(const NATIVE_INT_TYPE portNum, U32 utcDays, F64 timeOfDay, U64 captureNs)
+  {
+    this->m_lock.lock();
+    U64 fixNs = captureNs - this->m_fixLatencyNs;
+    I64 predictedNs = this->utcAt(fixNs);
+    I64 measuredNs = static_cast<I64>(utcDays) * NS_PER_DAY + static_cast<I64>(timeOfDay * NS_PER_SECOND);
+    I64 offsetNs = measuredNs - predictedNs;
+    F64 driftPpb = this->m_driftPpb.load(std::memory_order_relaxed);
+    U8 status = this->m_status.load(std::memory_order_relaxed);
+
+    if (status != GpsTimeStatus::LOCKED) {
+      // First fix, or first fix after holdover: step to the measurement
+      if (status == GpsTimeStatus::HOLDOVER && std::llabs(offsetNs) > STEP_REPORT_NS) {
+        this->log_WARNING_LO_Time_Stepped(static_cast<F64>(offsetNs) / 1.0e6);
+      }
+      this->m_catchingUp = false;
+      this->publish(measuredNs, fixNs, driftPpb, 0.0, 0, true);
+    } else {
+      // Slew the correction out over the next fix interval as a temporary rate term, so that served time is
+      // continuous and keeps advancing
+      U64 intervalNs = (fixNs > this->m_lastFixNs) ? fixNs - this->m_lastFixNs : DEFAULT_SLEW_NS;
+      U64 slewNs = FW_MAX(MIN_SLEW_NS, FW_MIN(MAX_SLEW_NS, intervalNs));
+      if (!this->m_catchingUp && std::llabs(offsetNs) > CATCH_UP_ENTER_NS) {
+        this->m_catchingUp = true;
+        this->log_WARNING_LO_Time_Slewing(static_cast<F64>(offsetNs) / 1.0e6);
+      } else if (this->m_catchingUp && std::llabs(offsetNs) < CATCH_UP_EXIT_NS) {
+        this->m_catchingUp = false;
+      }
+      F64 correctionNs = PHASE_GAIN * static_cast<F64>(offsetNs);
+      if (this->m_catchingUp) {
+        // Too large to be drift: remove all of it, as fast as allowed, and keep it out of the drift estimate
+        correctionNs = static_cast<F64>(offsetNs);
+      } else {
+        driftPpb += FREQUENCY_GAIN * static_cast<F64>(offsetNs) / static_cast<F64>(intervalNs) * 1.0e9;
+        driftPpb = std::fmax(-MAX_DRIFT_PPB, std::fmin(MAX_DRIFT_PPB, driftPpb));
+      }
+      F64 slewPpb = correctionNs / static_cast<F64>(slewNs) * 1.0e9;
+      slewPpb = std::fmax(-MAX_SLEW_PPB, std::fmin(MAX_SLEW_PPB, slewPpb));
+      // The new model starts where the current one is now, so no jump is served
+      U64 now = monotonicNs();
+      this->publish(this->utcAt(now), now, driftPpb, slewPpb, slewNs, false);
+    }
+    this->m_lastFixNs = fixNs;
+    this->m_lastOffsetNs = static_cast<F64>(offsetNs);
+
+    if (status != GpsTimeStatus::LOCKED) {
+      this->m_status.store(GpsTimeStatus::LOCKED, std::memory_order_relaxed);
+      this->log_ACTIVITY_HI_Time_Locked();
+    }
+    this->m_lock.unLock();
+  }
+
+  void GpsTime ::
+    schedIn_handler(const NATIVE_INT_TYPE portNum, NATIVE_UINT_TYPE context)
+  {
+    U64 now = monotonicNs();
+    this->m_lock.lock();
+    U8 status = this->m_status.load(std::memory_order_relaxed);
+    U32 fixAgeMs = 0;
+    if (status != GpsTimeStatus::FREE_RUN) {
+      fixAgeMs = static_cast<U32>(FW_MIN((now - this->m_lastFixNs) / 1000000, 0xFFFFFFFFULL));
+      if (status == GpsTimeStatus::LOCKED && (now - this->m_lastFixNs) > this->m_holdoverAfterNs) {
+        status = GpsTimeStatus::HOLDOVER;
+        this->m_status.store(status, std::memory_order_relaxed);
+        this->log_WARNING_LO_Time_Holdover(fixAgeMs);
+      }
+    }
+    F64 offsetUs = this->m_lastOffsetNs / 1.0e3;
+    F64 driftPpb = this->m_driftPpb.load(std::memory_order_relaxed);
+    this->m_lock.unLock();
+
+    this->tlmWrite_Time_Status(static_cast<GpsTimeStatus::T>(status));
+    this->tlmWrite_Time_OffsetUs(offsetUs);
+    this->tlmWrite_Time_DriftPpb(driftPpb);
+    this->tlmWrite_Time_FixAgeMs(fixAgeMs);
+    this->tlmWrite_Time_SystemOffsetMs(static_cast<F64>(this->utcAt(monotonicNs()) - systemNs()) / 1.0e6);
+  }
+
+  // ----------------------------------------------------------------------
+  // Helper functions
+  // ----------------------------------------------------------------------
+
+  I64 GpsTime ::
+    utcAt(U64 monoNs) const
+  {
+    I64 baseUtcNs;
+    U64 baseMonoNs;
+    F64 driftPpb;
+    F64 slewPpb;
+    U64 slewNs;
+    U32 seq;
+    do {
+      seq = this->m_seq.load(std::memory_order_acquire);
+      baseUtcNs = this->m_baseUtcNs.load(std::memory_order_relaxed);
+      baseMonoNs = this->m_baseMonoNs.load(std::memory_order_relaxed);
+      driftPpb = this->m_driftPpb.load(std::memory_order_relaxed);
+      slewPpb = this->m_slewPpb.load(std::memory_order_relaxed);
+      slewNs = this->m_slewNs.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != this->m_seq.load(std::memory_order_relaxed));
+
+    I64 elapsedNs = static_cast<I64>(monoNs - baseMonoNs);
+    I64 slewedNs = FW_MIN(elapsedNs, static_cast<I64>(slewNs));
+    return baseUtcNs + elapsedNs + static_cast<I64>(static_cast<F64>(elapsedNs) * driftPpb * 1.0e-9) +
+           static_cast<I64>(static_cast<F64>(slewedNs) * slewPpb * 1.0e-9);
+  }
+
+  I64 GpsTime ::
+    servedAt(U64 monoNs)
+  {
+    // A request that read the clock before a fix published on another thread can compute a time slightly
+    // earlier than the previous request on this thread; serve that one again instead. A step resets the floor.
+    U32 steps = this->m_steps.load();
+    I64 utcNs = this->utcAt(monoNs);
+    ServedFloor& floor = t_servedFloor;
+    if (floor.owner == this && floor.steps == steps && utcNs < floor.lastNs) {
+      return floor.lastNs;
+    }
+    floor.owner = this;
+    floor.steps = steps;
+    floor.lastNs = utcNs;
+    return utcNs;
+  }
+
+  void GpsTime ::
+    publish(I64 baseUtcNs, U64 baseMonoNs, F64 driftPpb, F64 slewPpb, U64 slewNs, bool step)
+  {
+    U32 seq = this->m_seq.load(std::memory_order_relaxed);
+    this->m_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->m_baseUtcNs.store(baseUtcNs, std::memory_order_relaxed);
+    this->m_baseMonoNs.store(baseMonoNs, std::memory_order_relaxed);
+    this->m_driftPpb.store(driftPpb, std::memory_order_relaxed);
+    this->m_slewPpb.store(slewPpb, std::memory_order_relaxed);
+    this->m_slewNs.store(slewNs, std::memory_order_relaxed);
+    if (step) {
+      this->m_steps++;
+    }
+    this->m_seq.store(seq + 2, std::memory_order_release);
+  }
+
+}
@@ -0,0 +1,116 @@
+// ======================================================================
+// \title  GpsTime.hpp
+// \author ting
+// \brief  hpp file for GpsTime component implementation class
+// ======================================================================
+
+#ifndef Gnc_GpsTime_HPP
+#define Gnc_GpsTime_HPP
+
+#include "Components/GpsTime/GpsTimeComponentAc.hpp"
+#include "Os/Mutex.hpp"
+
+#include <atomic>
+
+namespace Gnc {
+
+  /**
+   * GpsTime:
+   *   Serves UTC(mono) = baseUtc + (mono - baseMono) * (1 + drift) plus a
+   * slew term, where mono is std::chrono::steady_clock. The slew applies a
+   * fraction of the last measured offset as a temporary rate over the next
+   * fix interval, so served time never jumps while locked. The model is
+   * published by each GPS fix through a sequence lock, so timestamp requests
+   * never block and never write shared memory. Until the first fix the base
+   * is taken from the system clock.
+   */
+  class GpsTime :
+    public GpsTimeComponentBase
+  {
+
+    public:
+
+      // ----------------------------------------------------------------------
+      // Component construction and destruction
+      // ----------------------------------------------------------------------
+
+      //! Construct GpsTime object
+      GpsTime(
+          const char* const compName //!< The component name
+      );
+
+      //! Destroy GpsTime object
+      ~GpsTime();
+
+      //! Set the discipline parameters
+      void configure(
+          U32 holdoverAfterMs, //!< Fix age after which the clock enters holdover
+          U32 fixLatencyUs //!< Delay between the receiver's fix epoch and the sentence being received
+      );
+
+      //! Current std::chrono::steady_clock time in nanoseconds, the clock expected on fixIn
+      static U64 monotonicNs();
+
+    PRIVATE:
+      // ----------------------------------------------------------------------
+      // Handler implementations for typed input ports
+      // ----------------------------------------------------------------------
+
+      //! Handler implementation for timeGetPort
+      void timeGetPort_handler(
+          const NATIVE_INT_TYPE portNum, /*!< The port number*/
+          Fw::Time& time /*!< The time to fill in*/
+      ) override;
+
+      //! Handler implementation for fixIn
+      void fixIn_handler(
+          const NATIVE_INT_TYPE portNum, /*!< The port number*/
+          U32 utcDays, /*!< UTC days since 1970-01-01*/
+          F64 timeOfDay, /*!< UTC seconds since midnight*/
+          U64 captureNs /*!< Monotonic receive time*/
+      ) override;
+
+      //! Handler implementation for schedIn
+      void schedIn_handler(
+          const NATIVE_INT_TYPE portNum, /*!< The port number*/
+          NATIVE_UINT_TYPE context /*!< The call order*/
+      ) override;
+
+      // ----------------------------------------------------------------------
+      // Helper functions
+      // ----------------------------------------------------------------------
+
+      //! UTC nanoseconds since the epoch at a monotonic time, from the published snapshot
+      I64 utcAt(U64 monoNs) const;
+
+      //! UTC served for a monotonic time: utcAt, but never earlier than a time already served to the calling thread since the last step
+      I64 servedAt(U64 monoNs);
+
+      //! Publish a new model. A step allows the served time to go backwards. Only called with m_lock held.
+      void publish(I64 baseUtcNs, U64 baseMonoNs, F64 driftPpb, F64 slewPpb, U64 slewNs, bool step);
+
+      //!< Published snapshot, guarded by the sequence counter m_seq
+      std::atomic<U32> m_seq;
+      std::atomic<I64> m_baseUtcNs;
+      std::atomic<U64> m_baseMonoNs;
+      std::atomic<F64> m_driftPpb;
+      std::atomic<F64> m_slewPpb;
+      std::atomic<U64> m_slewNs;
+      std::atomic<U8> m_status;
+
+      //!< Number of steps, resetting the per-thread floor of servedAt
+      std::atomic<U32> m_steps;
+
+      //!< Estimator state, shared by fixIn and schedIn
+      Os::Mutex m_lock;
+      U64 m_lastFixNs;
+      F64 m_lastOffsetNs;
+      bool m_catchingUp;
+      U64 m_holdoverAfterNs;
+      U64 m_fixLatencyNs;
+
+  };
+
+}
+
+#endif
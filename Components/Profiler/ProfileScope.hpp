@@ -0,0 +1,57 @@
+// ======================================================================
+// \title  ProfileScope.hpp
+// \author ting
+// \brief  RAII handler timer feeding the Perf::Profiler component
+// ======================================================================
+
+#ifndef Perf_ProfileScope_HPP
+#define Perf_ProfileScope_HPP
+
+#include "Components/Profiler/Profiler.hpp"
+
+// Build with -DPERF_PROFILER_ENABLED=0 to compile every PROF_SCOPE out of the handlers.
+#ifndef PERF_PROFILER_ENABLED
+#define PERF_PROFILER_ENABLED 1
+#endif
+
+namespace Perf {
+
+  /**
+   * ProfileScope:
+   *   Times the enclosing block and reports it to the profiler on exit.
+   * While the profiler is OFF the cost is one relaxed atomic load.
+   */
+  class ProfileScope {
+    public:
+      explicit ProfileScope(U32 scopeId) : m_scopeId(scopeId), m_startNs(0) {
+        if (Profiler::isEnabled()) {
+          m_startNs = Profiler::nowNs();
+        }
+      }
+
+      ~ProfileScope() {
+        if (m_startNs != 0) {
+          Profiler::recordScope(m_scopeId, m_startNs, Profiler::nowNs() - m_startNs);
+        }
+      }
+
+    private:
+      ProfileScope(const ProfileScope&) = delete;
+      ProfileScope& operator=(const ProfileScope&) = delete;
+
+      U32 m_scopeId;
+      U64 m_startNs;
+  };
+
+}
+
+//! Time the rest of the enclosing block under the given name. Use at most once per block.
+#if PERF_PROFILER_ENABLED
+#define PROF_SCOPE(name)                                                     \
+  static const U32 profScopeId_ = Perf::Profiler::registerScope(name);      \
+  Perf::ProfileScope profScope_(profScopeId_)
+#else
+#define PROF_SCOPE(name)
+#endif
+
+#endif
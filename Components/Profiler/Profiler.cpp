@@ -0,0 +1,325 @@
+// ======================================================================
+// \title  Profiler.cpp
+// \author ting
+// \brief  cpp file for Profiler component implementation class
+// ======================================================================
+
+#include "Components/Profiler/Profiler.hpp"
+#include "Fw/Types/Assert.hpp"
+#include "Fw/Types/BasicTypes.hpp"
+#include "Os/File.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace Perf {
+
+  namespace {
+    //! Reaches the protected queue of any queued component. Never instantiated.
+    struct QueueAccess : public Fw::QueuedComponentBase {
+      static Os::Queue& of(Fw::QueuedComponentBase& component) {
+        return component.*(&QueueAccess::m_queue);
+      }
+    };
+
+    //! Hands out small thread indices for the trace file's "tid" field
+    std::atomic<U8> s_nextThread(0);
+    thread_local U8 t_thread = 0xFF;
+
+    U8 threadIndex() {
+      if (t_thread == 0xFF) {
+        t_thread = s_nextThread.fetch_add(1, std::memory_order_relaxed);
+      }
+      return t_thread;
+    }
+  }
+
+  // ----------------------------------------------------------------------
+  // Process-wide state
+  // ----------------------------------------------------------------------
+
+  std::atomic<U8> Profiler::s_mode(ProfMode::STATS);
+  std::atomic<Profiler*> Profiler::s_instance(nullptr);
+  std::atomic<U32> Profiler::s_activeTracers(0);
+  std::atomic<const char*> Profiler::s_scopeNames[PROF_MAX_SCOPES];
+  std::atomic<U32> Profiler::s_numScopes(0);
+  Profiler::ScopeStats Profiler::s_scopes[PROF_MAX_SCOPES];
+
+  // ----------------------------------------------------------------------
+  // Component construction and destruction
+  // ----------------------------------------------------------------------
+
+  Profiler :: Profiler(const char* const compName) : ProfilerComponentBase(compName),
+      m_reportedScopes(0),
+      m_numQueues(0),
+      m_trace(nullptr),
+      m_traceDepth(0),
+      m_traceHead(0),
+      m_allocator(nullptr),
+      m_allocationId(0)
+  {
+    memset(this->m_queues, 0, sizeof(this->m_queues));
+  }
+
+  Profiler ::
+    ~Profiler(void)
+  {
+
+  }
+
+  void Profiler ::
+    setup(U32 traceDepth, NATIVE_UINT_TYPE allocationId, Fw::MemAllocator& allocator)
+  {
+    FW_ASSERT(this->m_trace == nullptr);
+    // Power of two so the ring index stays consistent when the head counter wraps
+    FW_ASSERT(traceDepth > 0 && (traceDepth & (traceDepth - 1)) == 0, traceDepth);
+    NATIVE_UINT_TYPE size = traceDepth * sizeof(TraceRecord);
+    bool recoverable = false;
+    this->m_trace = static_cast<TraceRecord*>(allocator.allocate(allocationId, size, recoverable));
+    FW_ASSERT(this->m_trace != nullptr);
+    FW_ASSERT(size == traceDepth * sizeof(TraceRecord), size);
+    memset(this->m_trace, 0, size);
+    this->m_traceDepth = traceDepth;
+    this->m_allocator = &allocator;
+    this->m_allocationId = allocationId;
+    s_instance.store(this);
+  }
+
+  void Profiler ::
+    cleanup()
+  {
+    // Threads not stopped by teardown (e.g. the GPS UART) may still be inside recordScope
+    s_mode.store(ProfMode::OFF);
+    s_instance.store(nullptr);
+    while (s_activeTracers.load() != 0) {
+    }
+    if (this->m_trace != nullptr) {
+      this->m_allocator->deallocate(this->m_allocationId, this->m_trace);
+      this->m_trace = nullptr;
+      this->m_traceDepth = 0;
+    }
+  }
+
+  void Profiler ::
+    registerQueue(const char* name, Fw::QueuedComponentBase& component)
+  {
+    FW_ASSERT(this->m_numQueues < PROF_MAX_QUEUES, this->m_numQueues);
+    this->m_queues[this->m_numQueues].name = name;
+    this->m_queues[this->m_numQueues].queue = &QueueAccess::of(component);
+    this->m_numQueues++;
+  }
+
+  // ----------------------------------------------------------------------
+  // Process-wide scope timing
+  // ----------------------------------------------------------------------
+
+  U32 Profiler ::
+    registerScope(const char* name)
+  {
+    U32 id = s_numScopes.fetch_add(1, std::memory_order_relaxed);
+    if (id >= PROF_MAX_SCOPES) {
+      // Table full; recordScope ignores out of range ids
+      return PROF_MAX_SCOPES;
+    }
+    s_scopeNames[id].store(name, std::memory_order_release);
+    return id;
+  }
+
+  U64 Profiler ::
+    nowNs()
+  {
+    return static_cast<U64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  void Profiler ::
+    recordScope(U32 scopeId, U64 startNs, U64 durationNs)
+  {
+    if (scopeId >= PROF_MAX_SCOPES) {
+      return;
+    }
+    ScopeStats& stats = s_scopes[scopeId];
+    stats.calls.fetch_add(1, std::memory_order_relaxed);
+    stats.totalNs.fetch_add(durationNs, std::memory_order_relaxed);
+    U64 max = stats.maxNs.load(std::memory_order_relaxed);
+    while (durationNs > max && !stats.maxNs.compare_exchange_weak(max, durationNs, std::memory_order_relaxed)) {
+    }
+
+    if (s_mode.load(std::memory_order_relaxed) == ProfMode::TRACE) {
+      // Announce the write, then check again, so that cleanup and Prof_DumpTrace can leave TRACE and wait for it
+      s_activeTracers.fetch_add(1);
+      Profiler* instance = s_instance.load();
+      if (instance != nullptr && s_mode.load() == ProfMode::TRACE) {
+        U32 value = (durationNs > 0xFFFFFFFF) ? 0xFFFFFFFF : static_cast<U32>(durationNs);
+        instance->trace(TRACE_SCOPE, static_cast<U16>(scopeId), startNs, value);
+      }
+      s_activeTracers.fetch_sub(1);
+    }
+  }
+
+  void Profiler ::
+    trace(U8 kind, U16 id, U64 startNs, U32 value)
+  {
+    if (this->m_trace == nullptr) {
+      return;
+    }
+    U32 slot = this->m_traceHead.fetch_add(1, std::memory_order_relaxed) % this->m_traceDepth;
+    TraceRecord& record = this->m_trace[slot];
+    record.startNs = startNs;
+    record.value = value;
+    record.id = id;
+    record.kind = kind;
+    record.thread = threadIndex();
+  }
+
+  // ----------------------------------------------------------------------
+  // Handler implementations for user-defined typed input ports
+  // ----------------------------------------------------------------------
+
+  void Profiler ::
+    run_handler(const NATIVE_INT_TYPE portNum, NATIVE_UINT_TYPE context)
+  {
+    // Scope indices follow first-use order, so announce each new one to let the ground label the arrays
+    while (this->m_reportedScopes < PROF_MAX_SCOPES) {
+      const char* name = s_scopeNames[this->m_reportedScopes].load(std::memory_order_acquire);
+      if (name == nullptr) {
+        break;
+      }
+      Fw::LogStringArg logName(name);
+      this->log_ACTIVITY_LO_Prof_ScopeRegistered(this->m_reportedScopes, logName);
+      this->m_reportedScopes++;
+    }
+
+    U8 mode = s_mode.load(std::memory_order_relaxed);
+    if (mode == ProfMode::OFF) {
+      return;
+    }
+
+    // Sample every registered queue
+    ProfQueueCounts depths;
+    ProfQueueCounts highWater;
+    U64 now = nowNs();
+    for (U32 i = 0; i < PROF_MAX_QUEUES; i++) {
+      depths[i] = 0;
+      highWater[i] = 0;
+    }
+    for (U32 i = 0; i < this->m_numQueues; i++) {
+      NATIVE_INT_TYPE depth = this->m_queues[i].queue->getNumMsgs();
+      depths[i] = static_cast<U16>(depth);
+      highWater[i] = static_cast<U16>(this->m_queues[i].queue->getMaxMsgs());
+      if (mode == ProfMode::TRACE) {
+        this->trace(TRACE_QUEUE, static_cast<U16>(i), now, static_cast<U32>(depth));
+      }
+    }
+
+    // Drain the handler statistics accumulated since the last call
+    ProfScopeValues calls;
+    ProfScopeValues avgUs;
+    ProfScopeValues maxUs;
+    for (U32 i = 0; i < PROF_MAX_SCOPES; i++) {
+      U32 count = s_scopes[i].calls.exchange(0, std::memory_order_relaxed);
+      U64 total = s_scopes[i].totalNs.exchange(0, std::memory_order_relaxed);
+      U64 max = s_scopes[i].maxNs.exchange(0, std::memory_order_relaxed);
+      calls[i] = count;
+      avgUs[i] = (count > 0) ? static_cast<U32>(total / count / 1000) : 0;
+      maxUs[i] = static_cast<U32>(max / 1000);
+    }
+
+    this->tlmWrite_Prof_QueueDepth(depths);
+    this->tlmWrite_Prof_QueueHighWater(highWater);
+    this->tlmWrite_Prof_HandlerCalls(calls);
+    this->tlmWrite_Prof_HandlerAvgUs(avgUs);
+    this->tlmWrite_Prof_HandlerMaxUs(maxUs);
+    this->tlmWrite_Prof_TraceRecords(this->m_traceHead.load(std::memory_order_relaxed));
+  }
+
+  // ----------------------------------------------------------------------
+  // Command handler implementations
+  // ----------------------------------------------------------------------
+
+  void Profiler ::
+    Prof_SetMode_cmdHandler(
+        const FwOpcodeType opCode,
+        const U32 cmdSeq,
+        Perf::ProfMode mode
+    )
+  {
+    s_mode.store(static_cast<U8>(mode.e), std::memory_order_relaxed);
+    this->log_ACTIVITY_HI_Prof_ModeSet(mode);
+    this->cmdResponse_out(opCode, cmdSeq, Fw::CmdResponse::OK);
+  }
+
+  void Profiler ::
+    Prof_DumpTrace_cmdHandler(
+        const FwOpcodeType opCode,
+        const U32 cmdSeq,
+        const Fw::CmdStringArg& fileName
+    )
+  {
+    Fw::LogStringArg logName(fileName.toChar());
+
+    // Stop writers touching the ring while it is being read, and let those already inside recordScope finish
+    U8 mode = s_mode.load();
+    if (mode == ProfMode::TRACE) {
+      s_mode.store(ProfMode::STATS);
+      while (s_activeTracers.load() != 0) {
+      }
+    }
+    I32 written = this->writeTrace(fileName.toChar());
+    s_mode.store(mode);
+
+    if (written < 0) {
+      this->log_WARNING_HI_Prof_TraceDumpFailed(logName);
+      this->cmdResponse_out(opCode, cmdSeq, Fw::CmdResponse::EXECUTION_ERROR);
+      return;
+    }
+    this->log_ACTIVITY_HI_Prof_TraceDumped(static_cast<U32>(written), logName);
+    this->cmdResponse_out(opCode, cmdSeq, Fw::CmdResponse::OK);
+  }
+
+  I32 Profiler ::
+    writeTrace(const char* fileName)
+  {
+    Os::File file;
+    if (file.open(fileName, Os::File::OPEN_WRITE) != Os::File::OP_OK) {
+      return -1;
+    }
+
+    char line[256];
+    NATIVE_INT_TYPE size = 0;
+    bool ok = true;
+    U32 head = this->m_traceHead.load(std::memory_order_relaxed);
+    U32 count = (head < this->m_traceDepth) ? head : this->m_traceDepth;
+
+    size = snprintf(line, sizeof(line), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    ok = ok && (file.write(line, size) == Os::File::OP_OK);
+
+    for (U32 i = 0; ok && i < count; i++) {
+      const TraceRecord& record = this->m_trace[(head - count + i) % this->m_traceDepth];
+      const char* separator = (i + 1 < count) ? "," : "";
+      F64 tsUs = static_cast<F64>(record.startNs) / 1000.0;
+      if (record.kind == TRACE_SCOPE) {
+        const char* name = (record.id < PROF_MAX_SCOPES) ? s_scopeNames[record.id].load() : nullptr;
+        name = (name != nullptr) ? name : "unknown";
+        size = snprintf(line, sizeof(line),
+                        "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                        name, record.thread, tsUs, static_cast<F64>(record.value) / 1000.0, separator);
+      } else {
+        const char* name = (record.id < this->m_numQueues) ? this->m_queues[record.id].name : "unknown";
+        size = snprintf(line, sizeof(line),
+                        "{\"name\":\"queue.%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"depth\":%u}}%s\n",
+                        name, tsUs, record.value, separator);
+      }
+      if (size >= static_cast<NATIVE_INT_TYPE>(sizeof(line))) {
+        size = static_cast<NATIVE_INT_TYPE>(sizeof(line)) - 1;
+      }
+      ok = (file.write(line, size) == Os::File::OP_OK);
+    }
+
+    size = snprintf(line, sizeof(line), "]}\n");
+    ok = ok && (file.write(line, size) == Os::File::OP_OK);
+    file.close();
+    return ok ? static_cast<I32>(count) : -1;
+  }
+
+}
@@ -0,0 +1,171 @@
+// ======================================================================
+// \title  Profiler.hpp
+// \author ting
+// \brief  hpp file for Profiler component implementation class
+// ======================================================================
+
+#ifndef Perf_Profiler_HPP
+#define Perf_Profiler_HPP
+
+#include "Components/Profiler/ProfilerComponentAc.hpp"
+#include "Components/Profiler/FppConstantsAc.hpp"
+#include "Fw/Types/MemAllocator.hpp"
+
+#include <atomic>
+
+namespace Perf {
+
+  class Profiler :
+    public ProfilerComponentBase
+  {
+
+    /**
+   * TraceRecord:
+   *   One fixed-size entry of the trace ring. Scope records carry a start
+   * time and a duration, queue records carry a sample time and a depth.
+   */
+  struct TraceRecord {
+    U64 startNs;   // Monotonic time the scope started or the queue was sampled
+    U32 value;     // Scope duration in nanoseconds, or queue depth
+    U16 id;        // Scope or queue index
+    U8 kind;       // TRACE_SCOPE or TRACE_QUEUE
+    U8 thread;     // Small per-thread index assigned on first use
+  };
+
+  /**
+   * QueueProbe:
+   *   A registered active component queue.
+   */
+  struct QueueProbe {
+    const char* name;
+    Os::Queue* queue;
+  };
+
+  /**
+   * ScopeStats:
+   *   Handler statistics accumulated between two run calls. Updated from
+   * any thread, drained by the profiler thread.
+   */
+  struct ScopeStats {
+    std::atomic<U32> calls;
+    std::atomic<U64> totalNs;
+    std::atomic<U64> maxNs;
+  };
+
+    public:
+
+      enum {
+        TRACE_SCOPE = 0,
+        TRACE_QUEUE = 1
+      };
+
+      // ----------------------------------------------------------------------
+      // Component construction and destruction
+      // ----------------------------------------------------------------------
+
+      //! Construct Profiler object
+      Profiler(
+          const char* const compName //!< The component name
+      );
+
+      //! Destroy Profiler object
+      ~Profiler();
+
+      //! Allocate the trace ring and make this instance the process-wide profiler
+      void setup(
+          U32 traceDepth, //!< Number of records held by the trace ring, a power of two
+          NATIVE_UINT_TYPE allocationId, //!< Identifier passed to the allocator
+          Fw::MemAllocator& allocator //!< Allocator used for the trace ring
+      );
+
+      //! Turn the profiler OFF and release the trace ring once no thread is writing to it
+      void cleanup();
+
+      //! Add an active (or queued) component's queue to the sampled set
+      void registerQueue(
+          const char* name, //!< Instance name used in the trace file
+          Fw::QueuedComponentBase& component //!< Component owning the queue
+      );
+
+      // ----------------------------------------------------------------------
+      // Process-wide scope timing, used through PROF_SCOPE in ProfileScope.hpp
+      // ----------------------------------------------------------------------
+
+      //! Allocate a scope index for a handler name. Returns PROF_MAX_SCOPES when the table is full.
+      static U32 registerScope(const char* name);
+
+      //! Is handler timing currently enabled?
+      static bool isEnabled() {
+        return s_mode.load(std::memory_order_relaxed) != ProfMode::OFF;
+      }
+
+      //! Current monotonic time in nanoseconds
+      static U64 nowNs();
+
+      //! Account one execution of a scope
+      static void recordScope(U32 scopeId, U64 startNs, U64 durationNs);
+
+    PRIVATE:
+      // ----------------------------------------------------------------------
+      // Handler implementations for typed input ports
+      // ----------------------------------------------------------------------
+
+      //! Handler implementation for run
+      void run_handler(
+          const NATIVE_INT_TYPE portNum, /*!< The port number*/
+          NATIVE_UINT_TYPE context /*!< The call order*/
+      ) override;
+
+    PRIVATE:
+
+      // ----------------------------------------------------------------------
+      // Handler implementations for commands
+      // ----------------------------------------------------------------------
+
+      //! Handler implementation for command Prof_SetMode
+      void Prof_SetMode_cmdHandler(
+          const FwOpcodeType opCode, //!< The opcode
+          const U32 cmdSeq, //!< The command sequence number
+          Perf::ProfMode mode //!< The new profiler mode
+      ) override;
+
+      //! Handler implementation for command Prof_DumpTrace
+      void Prof_DumpTrace_cmdHandler(
+          const FwOpcodeType opCode, //!< The opcode
+          const U32 cmdSeq, //!< The command sequence number
+          const Fw::CmdStringArg& fileName //!< Destination path of the trace file
+      ) override;
+
+      //! Append a record to the trace ring, if tracing
+      void trace(U8 kind, U16 id, U64 startNs, U32 value);
+
+      //! Write the trace ring as Chrome trace event JSON. Returns records written, or -1 on error.
+      I32 writeTrace(const char* fileName);
+
+      //!< Scopes already announced with Prof_ScopeRegistered
+      U32 m_reportedScopes;
+
+      //!< Registered queues
+      QueueProbe m_queues[PROF_MAX_QUEUES];
+      U32 m_numQueues;
+
+      //!< Trace ring storage and the allocator it came from
+      TraceRecord* m_trace;
+      U32 m_traceDepth;
+      std::atomic<U32> m_traceHead;
+      Fw::MemAllocator* m_allocator;
+      NATIVE_UINT_TYPE m_allocationId;
+
+      //!< Process-wide state shared with PROF_SCOPE users
+      static std::atomic<U8> s_mode;
+      static std::atomic<Profiler*> s_instance;
+      static std::atomic<U32> s_activeTracers;
+      static std::atomic<const char*> s_scopeNames[PROF_MAX_SCOPES];
+      static std::atomic<U32> s_numScopes;
+      static ScopeStats s_scopes[PROF_MAX_SCOPES];
+
+  };
+
+}
+
+#endif
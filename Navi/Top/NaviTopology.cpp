@@ -50,6 +50,8 @@ enum TopologyConstants {
     // bufferManager constants
     FRAMER_BUFFER_SIZE = FW_MAX(FW_COM_BUFFER_MAX_SIZE, FW_FILE_BUFFER_MAX_SIZE + sizeof(U32)) + HASH_DIGEST_LENGTH + Svc::FpFrameHeader::SIZE,
     FRAMER_BUFFER_COUNT = 10,
+    FRAMER_BATCH_SIZE = 4096,
+    FRAMER_BATCH_LATENCY_MS = 200,
     DEFRAMER_BUFFER_SIZE = FW_MAX(FW_COM_BUFFER_MAX_SIZE, FW_FILE_BUFFER_MAX_SIZE + sizeof(U32)),
     DEFRAMER_BUFFER_COUNT = 10,
     COM_DRIVER_BUFFER_SIZE = 491520,
@@ -57,7 +59,11 @@ enum TopologyConstants {
     BUFFER_MANAGER_ID = 200,
     SUBSYSTEMS_DRIVER_BUFFER_SIZE = 491520,
     SUBSYSTEMS_DRIVER_BUFFER_COUNT = 30,
-    SUBSYSTEMS_BUFFER_MANAGER_ID = 201
+    SUBSYSTEMS_BUFFER_MANAGER_ID = 201,
+    PROFILER_TRACE_DEPTH = 4096,
+    GPS_TIME_HOLDOVER_AFTER_MS = 5000,
+    // About 75 characters of $GNRMC at 9600 baud, 1.04 ms each, between the fix epoch and the line end
+    GPS_TIME_FIX_LATENCY_US = 80000
 };
 
 // Ping entries are autocoded, however; this code is not properly exported. Thus, it is copied here.
@@ -87,7 +93,7 @@ void configureTopology(const TopologyState& state) {
     // Buffer managers need a configured set of buckets and an allocator used to allocate memory for those buckets.
     Svc::BufferManager::BufferBins upBuffMgrBins;
     memset(&upBuffMgrBins, 0, sizeof(upBuffMgrBins));
-    upBuffMgrBins.bins[0].bufferSize = FRAMER_BUFFER_SIZE;
+    upBuffMgrBins.bins[0].bufferSize = FW_MAX(FRAMER_BUFFER_SIZE, FRAMER_BATCH_SIZE);
     upBuffMgrBins.bins[0].numBuffers = FRAMER_BUFFER_COUNT;
     upBuffMgrBins.bins[1].bufferSize = DEFRAMER_BUFFER_SIZE;
     upBuffMgrBins.bins[1].numBuffers = DEFRAMER_BUFFER_COUNT;
@@ -97,8 +103,14 @@ void configureTopology(const TopologyState& state) {
 
     // Framer and Deframer components need to be passed a protocol handler
     framer.setup(framing);
+    // Framer packs frames into one send of up to FRAMER_BATCH_SIZE bytes. Its latency task, started below, sends a
+    // batch before its oldest packet has waited FRAMER_BATCH_LATENCY_MS; events are sent immediately.
+    framer.configure(FRAMER_BATCH_SIZE, FRAMER_BATCH_LATENCY_MS);
     deframer.setup(deframing);
 
+    // Time source enters holdover when fixes stop; the fix latency compensates the $GNRMC transmit delay
+    gpsTime.configure(GPS_TIME_HOLDOVER_AFTER_MS, GPS_TIME_FIX_LATENCY_US);
+
     // Command sequencer needs to allocate memory to hold contents of command sequences
     cmdSeq.allocateBuffer(0, mallocator, CMD_SEQ_BUFFER_SIZE);
 
@@ -155,6 +167,24 @@ void configureTopology(const TopologyState& state) {
     if (state.hostname != nullptr && state.port != 0) {
         comDriver.configure(state.hostname, state.port);
     }
+
+    // Profiler samples the active component queues in this order; it matches the Prof_QueueDepth array indices.
+    profiler.setup(PROFILER_TRACE_DEPTH, 0, mallocator);
+    profiler.registerQueue("blockDrv", blockDrv);
+    profiler.registerQueue("rateGroup1", rateGroup1);
+    profiler.registerQueue("rateGroup2", rateGroup2);
+    profiler.registerQueue("rateGroup3", rateGroup3);
+    profiler.registerQueue("cmdDisp", cmdDisp);
+    profiler.registerQueue("cmdSeq", cmdSeq);
+    profiler.registerQueue("comQueue", comQueue);
+    profiler.registerQueue("fileDownlink", fileDownlink);
+    profiler.registerQueue("fileManager", fileManager);
+    profiler.registerQueue("fileUplink", fileUplink);
+    profiler.registerQueue("eventLogger", eventLogger);
+    profiler.registerQueue("tlmSend", tlmSend);
+    profiler.registerQueue("prmDb", prmDb);
+    profiler.registerQueue("gps", gps);
+    profiler.registerQueue("health", health);
 }
 
 // Public functions for use in main program are namespaced with deployment name Navi
@@ -182,6 +212,9 @@ void setupTopology(const TopologyState& state) {
         // Uplink is configured for receive so a socket task is started
         comDriver.start(name, COMM_PRIORITY, Default::STACK_SIZE);
     }
+    // Framer latency task, at the priority of the socket task it sends through
+    Os::TaskString framerName("FramerTask");
+    framer.start(framerName, COMM_PRIORITY, Default::STACK_SIZE);
 
     // GPS
     if (state.gpsComm == nullptr) {
@@ -229,7 +262,9 @@ void teardownTopology(const TopologyState& state) {
     stopTasks(state);
     freeThreads(state);
 
-    // Other task clean-up.
+    // Other task clean-up. The framer task sends through comDriver, so it is stopped first.
+    framer.stop();
+    (void)framer.join();
     comDriver.stop();
     (void)comDriver.join();
 
@@ -237,5 +272,6 @@ void teardownTopology(const TopologyState& state) {
     cmdSeq.deallocateBuffer(mallocator);
     bufferManager.cleanup();
     subsystemsFileUplinkBufferManager.cleanup();
+    profiler.cleanup();
 }
 };  // namespace Navi
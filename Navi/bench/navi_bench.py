@@ -0,0 +1,480 @@
+#!/usr/bin/env python3
+# ======================================================================
+# \title  navi_bench.py
+# \author ting
+# \brief  end-to-end downlink/uplink throughput benchmark for the Navi deployment
+# ======================================================================
+"""
+Runs the Navi binary against a local TCP server that stands in for the F´ ground system.
+
+The server listens where `comDriver` connects (Navi's -a/-p options), deframes the F´ downlink, injects command and
+file-uplink load through Navi's deframer, and records:
+
+  * downlink bytes/s, frames/s and packets/s per packet type
+  * frame latency, from the Fw::Time stamped in a packet to its reception, separately for events and telemetry.
+    Event latency is the link delay. Telemetry is stamped when the channel is written and held by tlmSend until its
+    next 1 Hz run, so telemetry latency mostly reflects rate group phase.
+  * comQueue overflow episodes. ComQueue throttles QueueOverflow to one event per episode, re-armed once the queue
+    sends again, so this counts episodes rather than dropped packets
+  * CPU time and peak RSS of the Navi process
+
+The report is written as JSON so runs can be compared across builds and topology buffer settings. From the Navi
+deployment directory:
+
+    ./bench/navi_bench.py --binary build-artifacts/<platform>/Navi/bin/Navi --label baseline --report baseline.json
+    ./bench/navi_bench.py --binary build-artifacts/<platform>/Navi/bin/Navi --label batch-4k --report batch-4k.json
+    ./bench/navi_bench.py --compare baseline.json batch-4k.json
+
+Only the Python standard library is used. Packet layouts follow the default F´ configuration: U32 packet
+descriptors, opcodes, channel and event ids, and the Svc::FprimeFraming frame (0xDEADBEEF, U32 size, data, CRC32).
+"""
+import argparse
+import json
+import os
+import socket
+import struct
+import subprocess
+import sys
+import threading
+import time
+import zlib
+
+# ----------------------------------------------------------------------
+# F´ protocol constants
+# ----------------------------------------------------------------------
+
+FRAME_START = 0xDEADBEEF
+FRAME_HEADER = struct.Struct(">II")
+FRAME_HASH_SIZE = 4
+
+PACKET_COMMAND = 0
+PACKET_TELEM = 1
+PACKET_LOG = 2
+PACKET_FILE = 3
+PACKET_PACKETIZED_TLM = 4
+PACKET_NAMES = {
+    PACKET_COMMAND: "command",
+    PACKET_TELEM: "telemetry",
+    PACKET_LOG: "event",
+    PACKET_FILE: "file",
+    PACKET_PACKETIZED_TLM: "packetized_telemetry",
+}
+
+# Descriptor, then id, then Fw::Time (time base U16, context U8, seconds U32, microseconds U32)
+STAMPED_HEADER = struct.Struct(">IIHBII")
+
+FILE_START = 0
+FILE_DATA = 1
+FILE_END = 2
+
+# Svc.CommandDispatcher CMD_NO_OP: cmdDisp base id 0x0500, opcode 0
+DEFAULT_NO_OP_OPCODE = 0x0500
+# Svc.ComQueue QueueOverflow: comQueue base id 0x0700, event id 0
+DEFAULT_OVERFLOW_EVENT_ID = 0x0700
+
+# Latencies beyond this are treated as an unsynchronised flight clock rather than link delay
+MAX_PLAUSIBLE_LATENCY_S = 3600.0
+
+
+def frame(payload):
+    """Wrap a packet in an Svc::FprimeFraming frame"""
+    header = FRAME_HEADER.pack(FRAME_START, len(payload))
+    return header + payload + struct.pack(">I", zlib.crc32(header + payload) & 0xFFFFFFFF)
+
+
+def command_packet(opcode, args=b""):
+    """Fw::CmdPacket with pre-serialized arguments"""
+    return struct.pack(">II", PACKET_COMMAND, opcode) + args
+
+
+def file_path(path):
+    encoded = path.encode("ascii")
+    return struct.pack(">B", len(encoded)) + encoded
+
+
+def cfdp_checksum(data):
+    """CFDP::Checksum of a whole file: sum of big-endian 32-bit words, zero padded"""
+    value = 0
+    for offset in range(0, len(data), 4):
+        value = (value + int.from_bytes(data[offset:offset + 4].ljust(4, b"\0"), "big")) & 0xFFFFFFFF
+    return value
+
+
+def file_packets(source, destination, data, chunk):
+    """Fw::FilePacket START, DATA... and END packets uplinking `data` to `destination`"""
+    descriptor = struct.pack(">I", PACKET_FILE)
+    sequence = 0
+    packets = [descriptor + struct.pack(">BII", FILE_START, sequence, len(data)) + file_path(source) +
+               file_path(destination)]
+    for offset in range(0, len(data), chunk):
+        sequence += 1
+        piece = data[offset:offset + chunk]
+        packets.append(descriptor + struct.pack(">BIIH", FILE_DATA, sequence, offset, len(piece)) + piece)
+    sequence += 1
+    packets.append(descriptor + struct.pack(">BII", FILE_END, sequence, cfdp_checksum(data)))
+    return packets
+
+
+# ----------------------------------------------------------------------
+# Downlink accounting
+# ----------------------------------------------------------------------
+
+
+class Percentiles(object):
+    """Keeps every sample; runs are short enough for that to be cheap"""
+
+    def __init__(self):
+        self.samples = []
+
+    def add(self, value):
+        self.samples.append(value)
+
+    def summary(self, scale=1.0):
+        if not self.samples:
+            return None
+        ordered = sorted(self.samples)
+
+        def pick(fraction):
+            return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))] * scale
+
+        return {
+            "count": len(ordered),
+            "mean": sum(ordered) / len(ordered) * scale,
+            "p50": pick(0.50),
+            "p95": pick(0.95),
+            "p99": pick(0.99),
+            "max": ordered[-1] * scale,
+        }
+
+
+class Downlink(object):
+    """Deframes the byte stream received from Navi and accounts for what it carries"""
+
+    def __init__(self, overflow_event_id):
+        self.overflow_event_id = overflow_event_id
+        self.lock = threading.Lock()
+        self.pending = b""
+        self.recording = False
+        self.reset()
+
+    def reset(self):
+        self.bytes = 0
+        self.frames = 0
+        self.reads = 0
+        self.bad_frames = 0
+        self.packets = {}
+        self.overflow_episodes = 0
+        self.latency = {"event": Percentiles(), "telemetry": Percentiles()}
+        self.unsynchronised = 0
+
+    def receive(self, data):
+        with self.lock:
+            if self.recording:
+                self.bytes += len(data)
+                self.reads += 1
+            self.pending += data
+            self._deframe(time.time())
+
+    def _deframe(self, now):
+        while len(self.pending) >= FRAME_HEADER.size:
+            start, size = FRAME_HEADER.unpack_from(self.pending)
+            if start != FRAME_START:
+                self._resync()
+                continue
+            total = FRAME_HEADER.size + size + FRAME_HASH_SIZE
+            if len(self.pending) < total:
+                return
+            body = self.pending[:total - FRAME_HASH_SIZE]
+            (expected,) = struct.unpack_from(">I", self.pending, total - FRAME_HASH_SIZE)
+            if zlib.crc32(body) & 0xFFFFFFFF != expected:
+                if self.recording:
+                    self.bad_frames += 1
+                self._resync()
+                continue
+            self.pending = self.pending[total:]
+            if self.recording:
+                self.frames += 1
+                self._packet(body[FRAME_HEADER.size:], now)
+
+    def _resync(self):
+        index = self.pending.find(struct.pack(">I", FRAME_START), 1)
+        self.pending = self.pending[index:] if index > 0 else self.pending[-3:]
+
+    def _packet(self, payload, now):
+        if len(payload) < 4:
+            return
+        (descriptor,) = struct.unpack_from(">I", payload)
+        name = PACKET_NAMES.get(descriptor, "unknown")
+        self.packets[name] = self.packets.get(name, 0) + 1
+        if descriptor not in (PACKET_TELEM, PACKET_LOG) or len(payload) < STAMPED_HEADER.size:
+            return
+        _, identifier, _, _, seconds, useconds = STAMPED_HEADER.unpack_from(payload)
+        if descriptor == PACKET_LOG and identifier == self.overflow_event_id:
+            self.overflow_episodes += 1
+        latency = now - (seconds + useconds / 1e6)
+        if abs(latency) > MAX_PLAUSIBLE_LATENCY_S:
+            self.unsynchronised += 1
+        else:
+            self.latency["event" if descriptor == PACKET_LOG else "telemetry"].add(latency)
+
+
+# ----------------------------------------------------------------------
+# Navi process sampling
+# ----------------------------------------------------------------------
+
+
+def process_times(pid):
+    """(CPU seconds, RSS bytes) of a process from /proc, or None once the process is gone"""
+    try:
+        with open("/proc/%d/stat" % pid) as stat:
+            fields = stat.read().rsplit(")", 1)[1].split()
+    except (OSError, IndexError):
+        # Navi exited (and may have been reaped) between the liveness check and the read
+        return None
+    ticks = os.sysconf("SC_CLK_TCK")
+    cpu = (int(fields[11]) + int(fields[12])) / float(ticks)
+    rss = int(fields[21]) * os.sysconf("SC_PAGE_SIZE")
+    return cpu, rss
+
+
+# ----------------------------------------------------------------------
+# Benchmark run
+# ----------------------------------------------------------------------
+
+
+def run(args):
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind((args.address, args.port))
+    server.listen(1)
+    server.settimeout(args.connect_timeout)
+
+    workdir = os.path.abspath(args.workdir)
+    if not os.path.isdir(workdir):
+        os.makedirs(workdir)
+    log = open(os.path.join(workdir, "navi.log"), "w")
+    navi = subprocess.Popen([os.path.abspath(args.binary), "-a", args.address, "-p", str(args.port)],
+                            cwd=workdir, stdout=log, stderr=subprocess.STDOUT)
+    try:
+        connection, _ = server.accept()
+    except socket.timeout:
+        navi.kill()
+        sys.exit("Navi did not connect to %s:%d within %.0f s" % (args.address, args.port, args.connect_timeout))
+    connection.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    downlink = Downlink(args.overflow_event_id)
+    stop = threading.Event()
+
+    def reader():
+        while not stop.is_set():
+            try:
+                data = connection.recv(65536)
+            except OSError:
+                return
+            if not data:
+                return
+            downlink.receive(data)
+
+    uplink = {"commands": 0, "file_packets": 0, "files": 0, "bytes": 0}
+    send_lock = threading.Lock()
+
+    def send(packet):
+        data = frame(packet)
+        with send_lock:
+            connection.sendall(data)
+        return len(data)
+
+    def command_load():
+        if args.command_rate <= 0:
+            return
+        period = 1.0 / args.command_rate
+        deadline = time.time()
+        while not stop.is_set():
+            sent = send(command_packet(args.no_op_opcode))
+            uplink["commands"] += 1
+            uplink["bytes"] += sent
+            deadline += period
+            stop.wait(max(0.0, deadline - time.time()))
+
+    def file_load():
+        if args.file_size <= 0:
+            return
+        data = os.urandom(args.file_size)
+        index = 0
+        while not stop.is_set():
+            destination = os.path.join(args.file_destination, "navi_bench_%d.bin" % (index % 4))
+            for packet in file_packets("navi_bench.bin", destination, data, args.file_chunk):
+                if stop.is_set():
+                    return
+                uplink["bytes"] += send(packet)
+                uplink["file_packets"] += 1
+                if args.file_packet_gap > 0:
+                    stop.wait(args.file_packet_gap / 1000.0)
+            uplink["files"] += 1
+            index += 1
+
+    threads = [threading.Thread(target=target) for target in (reader, command_load, file_load)]
+    for thread in threads:
+        thread.daemon = True
+        thread.start()
+
+    # Let the topology start, then measure a fixed window
+    time.sleep(args.warmup)
+    with downlink.lock:
+        downlink.reset()
+        downlink.recording = True
+    uplink_start = dict(uplink)
+    sample = process_times(navi.pid)
+    alive = sample is not None
+    cpu_start = cpu_end = sample[0] if alive else 0.0
+    wall_start = time.time()
+    peak_rss = 0
+    while alive and time.time() - wall_start < args.duration:
+        time.sleep(min(1.0, args.duration))
+        sample = process_times(navi.pid)
+        alive = sample is not None and navi.poll() is None
+        if sample is not None:
+            cpu_end = sample[0]
+            peak_rss = max(peak_rss, sample[1])
+    elapsed = time.time() - wall_start
+    with downlink.lock:
+        downlink.recording = False
+
+    stop.set()
+    navi.terminate()
+    try:
+        navi.wait(timeout=10)
+    except subprocess.TimeoutExpired:
+        navi.kill()
+    connection.close()
+    server.close()
+    log.close()
+
+    report = {
+        "label": args.label,
+        "binary": os.path.abspath(args.binary),
+        "settings": {
+            "duration_s": args.duration,
+            "warmup_s": args.warmup,
+            "command_rate_hz": args.command_rate,
+            "file_size_bytes": args.file_size,
+            "file_chunk_bytes": args.file_chunk,
+        },
+        "navi_exited_early": not alive,
+        "elapsed_s": elapsed,
+        "downlink": {
+            "bytes_per_s": downlink.bytes / elapsed,
+            "frames_per_s": downlink.frames / elapsed,
+            "reads_per_s": downlink.reads / elapsed,
+            "bad_frames": downlink.bad_frames,
+            "packets_per_s": {name: count / elapsed for name, count in sorted(downlink.packets.items())},
+            "frame_latency_ms": {kind: samples.summary(1000.0) for kind, samples in sorted(downlink.latency.items())},
+            "unsynchronised_timestamps": downlink.unsynchronised,
+        },
+        "uplink": {
+            "commands_per_s": (uplink["commands"] - uplink_start["commands"]) / elapsed,
+            "file_packets_per_s": (uplink["file_packets"] - uplink_start["file_packets"]) / elapsed,
+            "files": uplink["files"] - uplink_start["files"],
+            "bytes_per_s": (uplink["bytes"] - uplink_start["bytes"]) / elapsed,
+        },
+        "com_queue_overflow_episodes": downlink.overflow_episodes,
+        "navi_cpu_percent": 100.0 * (cpu_end - cpu_start) / elapsed,
+        "navi_peak_rss_bytes": peak_rss,
+    }
+    return report
+
+
+# ----------------------------------------------------------------------
+# Reporting
+# ----------------------------------------------------------------------
+
+# Metrics shown when comparing reports, with the direction that counts as better
+COMPARED = [
+    ("downlink.bytes_per_s", "higher"),
+    ("downlink.frames_per_s", None),
+    ("downlink.reads_per_s", "lower"),
+    ("downlink.frame_latency_ms.event.p50", "lower"),
+    ("downlink.frame_latency_ms.event.p99", "lower"),
+    ("downlink.frame_latency_ms.telemetry.p50", "lower"),
+    ("downlink.frame_latency_ms.telemetry.p99", "lower"),
+    ("uplink.commands_per_s", "higher"),
+    ("uplink.bytes_per_s", "higher"),
+    ("com_queue_overflow_episodes", "lower"),
+    ("navi_cpu_percent", "lower"),
+    ("navi_peak_rss_bytes", "lower"),
+]
+
+
+def lookup(report, path):
+    value = report
+    for key in path.split("."):
+        if not isinstance(value, dict) or key not in value:
+            return None
+        value = value[key]
+    return value
+
+
+def compare(paths):
+    reports = []
+    for path in paths:
+        with open(path) as handle:
+            reports.append(json.load(handle))
+    labels = [report.get("label") or os.path.basename(path) for report, path in zip(reports, paths)]
+    print("%-42s" % "metric" + "".join("%18s" % label[:17] for label in labels))
+    for metric, better in COMPARED:
+        values = [lookup(report, metric) for report in reports]
+        row = "%-42s" % metric
+        for value in values:
+            row += "%18s" % ("-" if value is None else "%.2f" % value)
+        base = values[0]
+        last = values[-1]
+        if len(values) > 1 and base and last is not None:
+            change = 100.0 * (last - base) / base
+            verdict = ""
+            if better is not None and abs(change) >= 1.0:
+                verdict = " better" if (change > 0) == (better == "higher") else " worse"
+            row += "  %+.1f%%%s" % (change, verdict)
+        print(row)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--binary", help="Navi executable")
+    parser.add_argument("--label", default="", help="Name of this build/configuration in the report")
+    parser.add_argument("--report", help="Write the JSON report to this file")
+    parser.add_argument("--compare", nargs="+", metavar="REPORT", help="Compare reports instead of running")
+    parser.add_argument("--address", default="127.0.0.1", help="Address the stand-in ground system listens on")
+    parser.add_argument("--port", type=int, default=50000, help="Port the stand-in ground system listens on")
+    parser.add_argument("--workdir", default="navi-bench", help="Working directory for Navi (PrmDb.dat, log)")
+    parser.add_argument("--duration", type=float, default=30.0, help="Measured window in seconds")
+    parser.add_argument("--warmup", type=float, default=5.0, help="Seconds to run before measuring")
+    parser.add_argument("--connect-timeout", type=float, default=20.0, help="Seconds to wait for Navi to connect")
+    parser.add_argument("--command-rate", type=float, default=10.0, help="No-op commands per second, 0 disables")
+    parser.add_argument("--no-op-opcode", type=lambda text: int(text, 0), default=DEFAULT_NO_OP_OPCODE,
+                        help="Opcode of the no-op command")
+    parser.add_argument("--file-size", type=int, default=64 * 1024,
+                        help="Size of the file repeatedly uplinked, 0 disables")
+    parser.add_argument("--file-chunk", type=int, default=512, help="Data bytes per file packet")
+    parser.add_argument("--file-packet-gap", type=float, default=1.0,
+                        help="Milliseconds between file packets, so fileUplink is not overrun")
+    parser.add_argument("--file-destination", default="/tmp", help="Directory Navi writes uplinked files to")
+    parser.add_argument("--overflow-event-id", type=lambda text: int(text, 0), default=DEFAULT_OVERFLOW_EVENT_ID,
+                        help="Event id of comQueue.QueueOverflow")
+    args = parser.parse_args()
+
+    if args.compare:
+        compare(args.compare)
+        return
+    if not args.binary:
+        parser.error("--binary is required unless --compare is given")
+
+    report = run(args)
+    text = json.dumps(report, indent=2, sort_keys=True)
+    print(text)
+    if args.report:
+        with open(args.report, "w") as handle:
+            handle.write(text + "\n")
+
+
+if __name__ == "__main__":
+    main()